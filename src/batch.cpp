@@ -0,0 +1,193 @@
+#include "batch.h"
+#include "batch_kernel.h"
+#include "magic.h"
+#include "tables.h"
+
+namespace Batch {
+
+namespace {
+
+struct ScalarOps {
+    using V = uint64_t;
+    static constexpr int LANES = 1;
+
+    static V zero() { return 0; }
+    static V set1(uint64_t x) { return x; }
+    static V load(const uint64_t* p) { return *p; }
+    static void store(uint64_t* p, V v) { *p = v; }
+    static V and_(V a, V b) { return a & b; }
+    static V or_(V a, V b) { return a | b; }
+    static V xor_(V a, V b) { return a ^ b; }
+    static V andnot(V a, V b) { return a & ~b; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    template<int N> static V shl(V v) { return v << N; }
+    template<int N> static V shr(V v) { return v >> N; }
+    static V popcount(V v) { return static_cast<V>(__builtin_popcountll(v)); }
+    static V nonzero(V v) { return v ? ~0ULL : 0ULL; }
+    static V select(V mask, V a, V b) { return (a & mask) | (b & ~mask); }
+};
+
+// Legal en passant captures. The vector kernel leaves them out: they are
+// rare, and the captured pawn leaving the board can expose the king along a
+// rank, which the pin scan does not see. Every capture is checked by
+// looking for attacks on the king after it.
+int count_en_passant(const Positions& pos, size_t i) {
+    int ep = pos.en_passant_square[i];
+    if (ep < 0)
+        return 0;
+
+    Color us = static_cast<Color>(pos.side_to_move[i]);
+    Color them = (us == WHITE) ? BLACK : WHITE;
+    Bitboard capturers = MoveGen::pawn_attacks[them][ep] & pos.pieces[us][PAWN - PAWN][i];
+    if (!capturers)
+        return 0;
+
+    Bitboard occupied = EMPTY_BITBOARD;
+    for (int c = WHITE; c <= BLACK; c++)
+        for (int p = 0; p < PIECE_TYPE_NB; p++)
+            occupied |= pos.pieces[c][p][i];
+
+    int king = Bitboards::lsb(pos.pieces[us][KING - PAWN][i]);
+    Bitboard captured = 1ULL << (ep + ((us == WHITE) ? -8 : 8));
+    Bitboard diagonal = pos.pieces[them][BISHOP - PAWN][i] | pos.pieces[them][QUEEN - PAWN][i];
+    Bitboard straight = pos.pieces[them][ROOK - PAWN][i] | pos.pieces[them][QUEEN - PAWN][i];
+
+    int count = 0;
+    while (capturers) {
+        int from = Bitboards::lsb(capturers);
+        Bitboards::clear_bit(capturers, from);
+
+        Bitboard occ = (occupied ^ (1ULL << from) ^ captured) | (1ULL << ep);
+        bool attacked = (MoveGen::bishop_attacks(king, occ) & diagonal)
+                     || (MoveGen::rook_attacks(king, occ) & straight)
+                     || (MoveGen::knight_attacks[king] & pos.pieces[them][KNIGHT - PAWN][i])
+                     || (MoveGen::pawn_attacks[us][king] & pos.pieces[them][PAWN - PAWN][i] & ~captured);
+        count += !attacked;
+    }
+    return count;
+}
+
+// Castling moves, given the enemy attack set from the kernel
+int count_castling(const Positions& pos, size_t i, Bitboard enemy_attacks) {
+    Color us = static_cast<Color>(pos.side_to_move[i]);
+    int rights = pos.castling_rights[i] >> (us == WHITE ? 0 : 2);
+    if (!(rights & 3))
+        return 0;
+
+    Bitboard occupied = EMPTY_BITBOARD;
+    for (int c = WHITE; c <= BLACK; c++)
+        for (int p = 0; p < PIECE_TYPE_NB; p++)
+            occupied |= pos.pieces[c][p][i];
+
+    // Squares are given for white and moved to rank 8 for black
+    int shift = us == WHITE ? 0 : 56;
+    int count = 0;
+    if ((rights & 1) && !(occupied & (0x60ULL << shift)) && !(enemy_attacks & (0x70ULL << shift)))
+        count++;
+    if ((rights & 2) && !(occupied & (0x0EULL << shift)) && !(enemy_attacks & (0x1CULL << shift)))
+        count++;
+    return count;
+}
+
+} // namespace
+
+namespace detail {
+
+void analyze_scalar(const View& view, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+        analyze_lanes<ScalarOps>(view, i);
+}
+
+}
+
+void Positions::resize(size_t n) {
+    for (int c = WHITE; c <= BLACK; c++)
+        for (int p = 0; p < PIECE_TYPE_NB; p++)
+            pieces[c][p].resize(n);
+    side_to_move.resize(n);
+    castling_rights.resize(n);
+    en_passant_square.resize(n);
+}
+
+void Positions::set(size_t i, const Board& board) {
+    for (Color c : {WHITE, BLACK})
+        for (int p = PAWN; p < PIECE_NB; p++)
+            pieces[c][p - PAWN][i] = board.pieces(c, static_cast<Piece>(p));
+    side_to_move[i] = static_cast<uint8_t>(board.side_to_move);
+    castling_rights[i] = static_cast<uint8_t>(board.castling_rights);
+    en_passant_square[i] = static_cast<int8_t>(board.en_passant_square);
+}
+
+void Positions::push_back(const Board& board) {
+    resize(size() + 1);
+    set(size() - 1, board);
+}
+
+void Results::resize(size_t n) {
+    attacks[WHITE].resize(n);
+    attacks[BLACK].resize(n);
+    checkers.resize(n);
+    pinned.resize(n);
+    legal_moves.resize(n);
+}
+
+Backend best_backend() {
+#ifdef BATCH_AVX512
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq"))
+        return AVX512;
+#endif
+#ifdef BATCH_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return AVX2;
+#endif
+    return SCALAR;
+}
+
+const char* backend_name(Backend backend) {
+    switch (backend) {
+        case AVX512: return "avx512";
+        case AVX2:   return "avx2";
+        default:     return "scalar";
+    }
+}
+
+void analyze(const Positions& positions, Results& results, Backend backend) {
+    size_t n = positions.size();
+    results.resize(n);
+
+    detail::View view;
+    for (int c = WHITE; c <= BLACK; c++) {
+        for (int p = 0; p < PIECE_TYPE_NB; p++)
+            view.pieces[c][p] = positions.pieces[c][p].data();
+        view.attacks[c] = results.attacks[c].data();
+    }
+    view.side_to_move = positions.side_to_move.data();
+    view.checkers = results.checkers.data();
+    view.pinned = results.pinned.data();
+    view.legal_moves = results.legal_moves.data();
+
+    // Full vectors first, the remainder one position at a time
+    size_t vectorized = 0;
+#ifdef BATCH_AVX512
+    if (backend == AVX512) {
+        vectorized = n - n % 8;
+        detail::analyze_avx512(view, 0, vectorized);
+    }
+#endif
+#ifdef BATCH_AVX2
+    if (backend == AVX2) {
+        vectorized = n - n % 4;
+        detail::analyze_avx2(view, 0, vectorized);
+    }
+#endif
+    detail::analyze_scalar(view, vectorized, n);
+
+    for (size_t i = 0; i < n; i++) {
+        Color them = positions.side_to_move[i] == WHITE ? BLACK : WHITE;
+        results.legal_moves[i] += count_en_passant(positions, i)
+                                + count_castling(positions, i, results.attacks[them][i]);
+    }
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+#include <cstddef>
+#include <vector>
+
+// Attack sets, checks and legal move counts for many positions at once, for
+// labeling large datasets. Positions are stored in structure-of-arrays layout
+// so a vector register holds the same bitboard of 4 (AVX2) or 8 (AVX-512)
+// positions, and attacks are computed with Kogge-Stone fills instead of
+// per-square table lookups. The instruction set is picked at run time.
+namespace Batch {
+    // Element i of every array belongs to position i
+    struct Positions {
+        std::vector<Bitboard> pieces[COLOR_NB][PIECE_TYPE_NB];  // [c][piece - PAWN]
+        std::vector<uint8_t> side_to_move;
+        std::vector<uint8_t> castling_rights;
+        std::vector<int8_t> en_passant_square;  // -1 if none
+
+        size_t size() const { return side_to_move.size(); }
+        void resize(size_t n);
+        void set(size_t i, const Board& board);
+        void push_back(const Board& board);
+    };
+
+    struct Results {
+        std::vector<Bitboard> attacks[COLOR_NB];  // Squares attacked by each color
+        std::vector<Bitboard> checkers;           // Pieces giving check to the side to move
+        std::vector<Bitboard> pinned;             // Pieces of the side to move pinned to its king
+        std::vector<uint16_t> legal_moves;        // Same as MoveGen::count_legal_moves
+
+        void resize(size_t n);
+    };
+
+    enum Backend {
+        SCALAR,
+        AVX2,
+        AVX512
+    };
+
+    // Widest backend both compiled in and supported by this CPU
+    Backend best_backend();
+    const char* backend_name(Backend backend);
+
+    // Fill results (resized to positions.size()) for every position
+    void analyze(const Positions& positions, Results& results, Backend backend = best_backend());
+}
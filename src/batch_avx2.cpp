@@ -0,0 +1,52 @@
+// Compiled with -mavx2; reached only through Batch::analyze after a CPU check
+#include "batch_kernel.h"
+
+#include <immintrin.h>
+
+namespace Batch::detail {
+
+namespace {
+
+struct Avx2Ops {
+    using V = __m256i;
+    static constexpr int LANES = 4;
+
+    static V zero() { return _mm256_setzero_si256(); }
+    static V set1(uint64_t x) { return _mm256_set1_epi64x(static_cast<long long>(x)); }
+    static V load(const uint64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(uint64_t* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    static V and_(V a, V b) { return _mm256_and_si256(a, b); }
+    static V or_(V a, V b) { return _mm256_or_si256(a, b); }
+    static V xor_(V a, V b) { return _mm256_xor_si256(a, b); }
+    static V andnot(V a, V b) { return _mm256_andnot_si256(b, a); }
+    static V add(V a, V b) { return _mm256_add_epi64(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_epi64(a, b); }
+    template<int N> static V shl(V v) { return _mm256_slli_epi64(v, N); }
+    template<int N> static V shr(V v) { return _mm256_srli_epi64(v, N); }
+
+    // No 64-bit popcount in AVX2: count nibbles with a shuffle lookup, then
+    // sum the eight bytes of each lane
+    static V popcount(V v) {
+        const V lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                          0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const V low_nibbles = _mm256_set1_epi8(0x0F);
+        V lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_nibbles));
+        V hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibbles));
+        return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+    }
+
+    static V nonzero(V v) {
+        return _mm256_xor_si256(_mm256_cmpeq_epi64(v, _mm256_setzero_si256()), _mm256_set1_epi64x(-1));
+    }
+
+    static V select(V mask, V a, V b) { return _mm256_blendv_epi8(b, a, mask); }
+};
+
+} // namespace
+
+void analyze_avx2(const View& view, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += Avx2Ops::LANES)
+        analyze_lanes<Avx2Ops>(view, i);
+}
+
+}
@@ -0,0 +1,47 @@
+// Compiled with -mavx512f -mavx512vpopcntdq; reached only through
+// Batch::analyze after a CPU check
+#include "batch_kernel.h"
+
+#include <immintrin.h>
+
+namespace Batch::detail {
+
+namespace {
+
+// Plain bitwise operations and shifts use GCC vector extensions: GCC 12's
+// AVX-512 intrinsics for them trip -Wuninitialized on their internal
+// _mm512_undefined_epi32() operand. The compiler emits the same instructions.
+struct Avx512Ops {
+    typedef unsigned long long V __attribute__((vector_size(64)));
+    static constexpr int LANES = 8;
+
+    static V zero() { return V{}; }
+    static V set1(uint64_t x) { return V{} + x; }
+    static V load(const uint64_t* p) { return reinterpret_cast<V>(_mm512_loadu_si512(p)); }
+    static void store(uint64_t* p, V v) { _mm512_storeu_si512(p, reinterpret_cast<__m512i>(v)); }
+    static V and_(V a, V b) { return a & b; }
+    static V or_(V a, V b) { return a | b; }
+    static V xor_(V a, V b) { return a ^ b; }
+    static V andnot(V a, V b) { return a & ~b; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    template<int N> static V shl(V v) { return v << N; }
+    template<int N> static V shr(V v) { return v >> N; }
+    static V popcount(V v) { return reinterpret_cast<V>(_mm512_popcnt_epi64(reinterpret_cast<__m512i>(v))); }
+
+    static V nonzero(V v) {
+        __m512i x = reinterpret_cast<__m512i>(v);
+        return reinterpret_cast<V>(_mm512_maskz_set1_epi64(_mm512_test_epi64_mask(x, x), -1));
+    }
+
+    static V select(V mask, V a, V b) { return (a & mask) | (b & ~mask); }
+};
+
+} // namespace
+
+void analyze_avx512(const View& view, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += Avx512Ops::LANES)
+        analyze_lanes<Avx512Ops>(view, i);
+}
+
+}
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "types.h"
+
+#include <cstddef>
+
+// Lane-parallel attack and move counting kernel behind Batch::analyze. It is
+// written once against a small vector interface (Ops) and compiled in a
+// separate translation unit per instruction set, each with its own -m flags.
+// Everything here has internal linkage so the differently compiled copies
+// never get merged by the linker; do not call shared inline functions from
+// here for the same reason.
+//
+// Ops provides, for a vector type V of Ops::LANES 64-bit lanes:
+//   zero, set1, load, store, and_, or_, xor_, andnot (a & ~b), add, sub,
+//   shl<n>, shr<n>, popcount (per lane), nonzero (all ones where a lane is
+//   non-zero) and select(mask, a, b).
+namespace Batch::detail {
+    // Raw views of the structure-of-arrays input and output
+    struct View {
+        const Bitboard* pieces[COLOR_NB][PIECE_TYPE_NB];  // [c][piece - PAWN]
+        const uint8_t* side_to_move;
+        Bitboard* attacks[COLOR_NB];
+        Bitboard* checkers;
+        Bitboard* pinned;
+        uint16_t* legal_moves;
+    };
+
+    // Entry points, one per backend, each processing positions [begin, end)
+    void analyze_scalar(const View& view, size_t begin, size_t end);
+    void analyze_avx2(const View& view, size_t begin, size_t end);
+    void analyze_avx512(const View& view, size_t begin, size_t end);
+
+    namespace {
+        constexpr Bitboard NOT_FILE_A = 0xFEFEFEFEFEFEFEFEULL;
+        constexpr Bitboard NOT_FILE_H = 0x7F7F7F7F7F7F7F7FULL;
+        constexpr Bitboard RANK_3 = 0x0000000000FF0000ULL;
+        constexpr Bitboard RANK_6 = 0x0000FF0000000000ULL;
+        constexpr Bitboard PROMOTION_RANKS = 0xFF000000000000FFULL;
+
+        // Shift every lane by S squares (negative: towards a1), dropping the
+        // bits that wrap around a board edge for the eight ray directions
+        template<class Ops, int S>
+        inline typename Ops::V shift(typename Ops::V v) {
+            if constexpr (S > 0)
+                return Ops::template shl<S>(v);
+            else
+                return Ops::template shr<-S>(v);
+        }
+
+        template<int D>
+        constexpr Bitboard wrap_mask() {
+            // East-going directions (+1, +9, -7) must not land on file A,
+            // west-going ones (-1, -9, +7) not on file H
+            return (D == 1 || D == 9 || D == -7) ? NOT_FILE_A
+                 : (D == -1 || D == -9 || D == 7) ? NOT_FILE_H
+                 : ~0ULL;
+        }
+
+        template<class Ops, int D>
+        inline typename Ops::V step(typename Ops::V v) {
+            return Ops::and_(shift<Ops, D>(v), Ops::set1(wrap_mask<D>()));
+        }
+
+        // Kogge-Stone occluded fill of `gen` along direction D through the
+        // `empty` squares, shifted one more step: every square a slider on
+        // `gen` reaches in direction D, including the first blocker
+        template<class Ops, int D>
+        inline typename Ops::V slide(typename Ops::V gen, typename Ops::V empty) {
+            using V = typename Ops::V;
+            V prop = Ops::and_(empty, Ops::set1(wrap_mask<D>()));
+            gen = Ops::or_(gen, Ops::and_(prop, shift<Ops, D>(gen)));
+            prop = Ops::and_(prop, shift<Ops, D>(prop));
+            gen = Ops::or_(gen, Ops::and_(prop, shift<Ops, 2 * D>(gen)));
+            prop = Ops::and_(prop, shift<Ops, 2 * D>(prop));
+            gen = Ops::or_(gen, Ops::and_(prop, shift<Ops, 4 * D>(gen)));
+            return step<Ops, D>(gen);
+        }
+
+        template<class Ops>
+        inline typename Ops::V knight_attacks(typename Ops::V n) {
+            using V = typename Ops::V;
+            const V not_a = Ops::set1(NOT_FILE_A), not_h = Ops::set1(NOT_FILE_H);
+            const V not_ab = Ops::set1(0xFCFCFCFCFCFCFCFCULL), not_gh = Ops::set1(0x3F3F3F3F3F3F3F3FULL);
+            V a = Ops::or_(Ops::and_(Ops::template shl<17>(n), not_a), Ops::and_(Ops::template shl<15>(n), not_h));
+            V b = Ops::or_(Ops::and_(Ops::template shl<10>(n), not_ab), Ops::and_(Ops::template shl<6>(n), not_gh));
+            V c = Ops::or_(Ops::and_(Ops::template shr<17>(n), not_h), Ops::and_(Ops::template shr<15>(n), not_a));
+            V d = Ops::or_(Ops::and_(Ops::template shr<10>(n), not_gh), Ops::and_(Ops::template shr<6>(n), not_ab));
+            return Ops::or_(Ops::or_(a, b), Ops::or_(c, d));
+        }
+
+        template<class Ops>
+        inline typename Ops::V king_attacks(typename Ops::V k) {
+            using V = typename Ops::V;
+            V row = Ops::or_(k, Ops::or_(step<Ops, 1>(k), step<Ops, -1>(k)));
+            V around = Ops::or_(row, Ops::or_(shift<Ops, 8>(row), shift<Ops, -8>(row)));
+            return Ops::andnot(around, k);
+        }
+
+        template<class Ops>
+        inline typename Ops::V white_pawn_attacks(typename Ops::V p) {
+            return Ops::or_(step<Ops, 7>(p), step<Ops, 9>(p));
+        }
+
+        template<class Ops>
+        inline typename Ops::V black_pawn_attacks(typename Ops::V p) {
+            return Ops::or_(step<Ops, -7>(p), step<Ops, -9>(p));
+        }
+
+        // Moves to `targets`, promotions counting once per promotion piece
+        template<class Ops>
+        inline typename Ops::V count_pawn_targets(typename Ops::V targets) {
+            const typename Ops::V promo = Ops::set1(PROMOTION_RANKS);
+            return Ops::add(Ops::popcount(Ops::andnot(targets, promo)),
+                            Ops::template shl<2>(Ops::popcount(Ops::and_(targets, promo))));
+        }
+
+        // Pushes and captures of white and black pawns. Every lane holds pawns
+        // of one color only, so both formulas are applied and summed.
+        template<class Ops>
+        inline typename Ops::V count_pawn_moves(typename Ops::V white, typename Ops::V black,
+                                                typename Ops::V empty, typename Ops::V enemies,
+                                                typename Ops::V mask) {
+            using V = typename Ops::V;
+            V w1 = Ops::and_(shift<Ops, 8>(white), empty);
+            V w2 = Ops::and_(shift<Ops, 8>(Ops::and_(w1, Ops::set1(RANK_3))), empty);
+            V b1 = Ops::and_(shift<Ops, -8>(black), empty);
+            V b2 = Ops::and_(shift<Ops, -8>(Ops::and_(b1, Ops::set1(RANK_6))), empty);
+
+            V count = Ops::popcount(Ops::and_(Ops::or_(w2, b2), mask));
+            count = Ops::add(count, count_pawn_targets<Ops>(Ops::and_(Ops::or_(w1, b1), mask)));
+            count = Ops::add(count, count_pawn_targets<Ops>(Ops::and_(step<Ops, 7>(white), Ops::and_(enemies, mask))));
+            count = Ops::add(count, count_pawn_targets<Ops>(Ops::and_(step<Ops, 9>(white), Ops::and_(enemies, mask))));
+            count = Ops::add(count, count_pawn_targets<Ops>(Ops::and_(step<Ops, -7>(black), Ops::and_(enemies, mask))));
+            count = Ops::add(count, count_pawn_targets<Ops>(Ops::and_(step<Ops, -9>(black), Ops::and_(enemies, mask))));
+            return count;
+        }
+
+        // Per-lane state shared by the eight ray directions
+        template<class Ops>
+        struct Lanes {
+            using V = typename Ops::V;
+            V white_lanes, black_lanes;         // All ones where white / black is to move
+            V empty, own, king;
+            V own_pawns, own_diagonal, own_straight;
+            V enemy_diagonal, enemy_straight;
+
+            V enemy_attacks = Ops::zero();      // Enemy slider attacks
+            V king_danger = Ops::zero();        // The same with our king removed
+            V own_attacks = Ops::zero();        // Our slider attacks
+            V checkers = Ops::zero();
+            V pinned = Ops::zero();
+            V check_rays = Ops::zero();         // Rays from the king to a slider checker
+            V pinned_moves = Ops::zero();       // Legal only when not in check
+            V moves = Ops::zero();
+        };
+
+        // First pass over direction D: enemy slider attacks, slider checks,
+        // pins and the moves of pinned pieces along their pin line
+        template<class Ops, int D>
+        inline void scan_direction(Lanes<Ops>& l) {
+            using V = typename Ops::V;
+            constexpr bool diagonal = D == 7 || D == 9 || D == -7 || D == -9;
+            const V own_sliders = diagonal ? l.own_diagonal : l.own_straight;
+            const V enemy_sliders = diagonal ? l.enemy_diagonal : l.enemy_straight;
+
+            l.enemy_attacks = Ops::or_(l.enemy_attacks, slide<Ops, D>(enemy_sliders, l.empty));
+            l.king_danger = Ops::or_(l.king_danger, slide<Ops, D>(enemy_sliders, Ops::or_(l.empty, l.king)));
+
+            // Ray from our king up to and including the first piece
+            V ray = slide<Ops, D>(l.king, l.empty);
+            V checker = Ops::and_(ray, enemy_sliders);
+            l.checkers = Ops::or_(l.checkers, checker);
+            l.check_rays = Ops::or_(l.check_rays, Ops::and_(ray, Ops::nonzero(checker)));
+
+            // Pin: our piece first, an enemy slider of this direction next
+            V blocker = Ops::and_(ray, l.own);
+            V beyond = slide<Ops, D>(blocker, l.empty);
+            V pinner = Ops::and_(beyond, enemy_sliders);
+            V pinned = Ops::and_(blocker, Ops::nonzero(pinner));
+            l.pinned = Ops::or_(l.pinned, pinned);
+
+            // A pinned slider of this direction moves along the pin line only:
+            // towards the king, or up to and including the pinner
+            V segment = Ops::andnot(Ops::or_(ray, beyond), pinned);
+            V slides = Ops::nonzero(Ops::and_(pinned, own_sliders));
+            l.pinned_moves = Ops::add(l.pinned_moves, Ops::and_(Ops::popcount(segment), slides));
+
+            // A pinned pawn pushes along a vertical pin and captures the pinner
+            // along a diagonal one
+            V pawn = Ops::and_(pinned, l.own_pawns);
+            if constexpr (D == 8 || D == -8) {
+                l.pinned_moves = Ops::add(l.pinned_moves,
+                    count_pawn_moves<Ops>(Ops::and_(pawn, l.white_lanes), Ops::and_(pawn, l.black_lanes),
+                                          l.empty, Ops::zero(), Ops::set1(~0ULL)));
+            } else if constexpr (diagonal) {
+                V captures = Ops::or_(Ops::and_(white_pawn_attacks<Ops>(pawn), l.white_lanes),
+                                      Ops::and_(black_pawn_attacks<Ops>(pawn), l.black_lanes));
+                l.pinned_moves = Ops::add(l.pinned_moves, count_pawn_targets<Ops>(Ops::and_(captures, pinner)));
+            }
+        }
+
+        // Second pass, once pins and the check mask are known: our slider
+        // attacks and the moves of our unpinned sliders. Rays in one direction
+        // never overlap, so the popcount of their union is the sum over the
+        // pieces.
+        template<class Ops, int D>
+        inline void slider_moves(Lanes<Ops>& l, typename Ops::V targets) {
+            constexpr bool diagonal = D == 7 || D == 9 || D == -7 || D == -9;
+            const typename Ops::V own_sliders = diagonal ? l.own_diagonal : l.own_straight;
+
+            l.own_attacks = Ops::or_(l.own_attacks, slide<Ops, D>(own_sliders, l.empty));
+            l.moves = Ops::add(l.moves, Ops::popcount(Ops::and_(
+                slide<Ops, D>(Ops::andnot(own_sliders, l.pinned), l.empty), targets)));
+        }
+
+        // Knight moves to `targets`, one popcount per jump: each jump maps
+        // distinct knights to distinct squares
+        template<class Ops>
+        inline typename Ops::V count_knight_moves(typename Ops::V n, typename Ops::V targets) {
+            using V = typename Ops::V;
+            const V not_a = Ops::set1(NOT_FILE_A), not_h = Ops::set1(NOT_FILE_H);
+            const V not_ab = Ops::set1(0xFCFCFCFCFCFCFCFCULL), not_gh = Ops::set1(0x3F3F3F3F3F3F3F3FULL);
+            V t_a = Ops::and_(targets, not_a), t_h = Ops::and_(targets, not_h);
+            V t_ab = Ops::and_(targets, not_ab), t_gh = Ops::and_(targets, not_gh);
+
+            V count = Ops::popcount(Ops::and_(Ops::template shl<17>(n), t_a));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shl<15>(n), t_h)));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shl<10>(n), t_ab)));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shl<6>(n), t_gh)));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shr<17>(n), t_h)));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shr<15>(n), t_a)));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shr<10>(n), t_gh)));
+            count = Ops::add(count, Ops::popcount(Ops::and_(Ops::template shr<6>(n), t_ab)));
+            return count;
+        }
+
+        // Analyze Ops::LANES positions starting at index i. Castling and en
+        // passant are left to the caller.
+        template<class Ops>
+        inline void analyze_lanes(const View& view, size_t i) {
+            using V = typename Ops::V;
+
+            uint64_t stm[Ops::LANES];
+            for (int lane = 0; lane < Ops::LANES; lane++)
+                stm[lane] = view.side_to_move[i + lane] == BLACK ? ~0ULL : 0ULL;
+
+            Lanes<Ops> l;
+            l.black_lanes = Ops::load(stm);
+            l.white_lanes = Ops::andnot(Ops::set1(~0ULL), l.black_lanes);
+
+            V pieces[COLOR_NB][PIECE_TYPE_NB];
+            V side[COLOR_NB] = {Ops::zero(), Ops::zero()};
+            for (int c = WHITE; c <= BLACK; c++) {
+                for (int p = 0; p < PIECE_TYPE_NB; p++) {
+                    pieces[c][p] = Ops::load(view.pieces[c][p] + i);
+                    side[c] = Ops::or_(side[c], pieces[c][p]);
+                }
+            }
+
+            // Our and the enemy's pieces, per lane
+            auto own = [&](Piece p) { return Ops::select(l.black_lanes, pieces[BLACK][p - PAWN], pieces[WHITE][p - PAWN]); };
+            auto enemy = [&](Piece p) { return Ops::select(l.black_lanes, pieces[WHITE][p - PAWN], pieces[BLACK][p - PAWN]); };
+
+            l.own = Ops::select(l.black_lanes, side[BLACK], side[WHITE]);
+            V enemies = Ops::select(l.black_lanes, side[WHITE], side[BLACK]);
+            l.empty = Ops::andnot(Ops::set1(~0ULL), Ops::or_(l.own, enemies));
+            l.king = own(KING);
+            l.own_pawns = own(PAWN);
+            l.own_diagonal = Ops::or_(own(BISHOP), own(QUEEN));
+            l.own_straight = Ops::or_(own(ROOK), own(QUEEN));
+            l.enemy_diagonal = Ops::or_(enemy(BISHOP), enemy(QUEEN));
+            l.enemy_straight = Ops::or_(enemy(ROOK), enemy(QUEEN));
+
+            scan_direction<Ops, 8>(l);
+            scan_direction<Ops, -8>(l);
+            scan_direction<Ops, 1>(l);
+            scan_direction<Ops, -1>(l);
+            scan_direction<Ops, 9>(l);
+            scan_direction<Ops, 7>(l);
+            scan_direction<Ops, -7>(l);
+            scan_direction<Ops, -9>(l);
+
+            // Leaper and pawn attacks. Enemy pawns attack like pawns of the
+            // other color, and our king is attacked from where a pawn of our
+            // color standing on it would attack.
+            V enemy_pawns = enemy(PAWN), enemy_knights = enemy(KNIGHT);
+            V enemy_pawn_attacks = Ops::select(l.black_lanes, white_pawn_attacks<Ops>(enemy_pawns),
+                                                              black_pawn_attacks<Ops>(enemy_pawns));
+            V enemy_leapers = Ops::or_(enemy_pawn_attacks, Ops::or_(knight_attacks<Ops>(enemy_knights),
+                                                                     king_attacks<Ops>(enemy(KING))));
+            l.enemy_attacks = Ops::or_(l.enemy_attacks, enemy_leapers);
+            l.king_danger = Ops::or_(l.king_danger, enemy_leapers);
+
+            V king_pawn_squares = Ops::select(l.black_lanes, black_pawn_attacks<Ops>(l.king),
+                                                             white_pawn_attacks<Ops>(l.king));
+            l.checkers = Ops::or_(l.checkers, Ops::or_(Ops::and_(king_pawn_squares, enemy_pawns),
+                                                       Ops::and_(knight_attacks<Ops>(l.king), enemy_knights)));
+
+            V in_check = Ops::nonzero(l.checkers);
+            V double_check = Ops::nonzero(Ops::and_(l.checkers, Ops::sub(l.checkers, Ops::set1(1))));
+            V check_mask = Ops::select(in_check, Ops::or_(l.checkers, l.check_rays), Ops::set1(~0ULL));
+            V targets = Ops::andnot(check_mask, l.own);
+
+            slider_moves<Ops, 8>(l, targets);
+            slider_moves<Ops, -8>(l, targets);
+            slider_moves<Ops, 1>(l, targets);
+            slider_moves<Ops, -1>(l, targets);
+            slider_moves<Ops, 9>(l, targets);
+            slider_moves<Ops, 7>(l, targets);
+            slider_moves<Ops, -7>(l, targets);
+            slider_moves<Ops, -9>(l, targets);
+
+            V own_knights = own(KNIGHT);
+            V free_pawns = Ops::andnot(l.own_pawns, l.pinned);
+            V moves = l.moves;
+            moves = Ops::add(moves, count_knight_moves<Ops>(Ops::andnot(own_knights, l.pinned), targets));
+            moves = Ops::add(moves, count_pawn_moves<Ops>(Ops::and_(free_pawns, l.white_lanes),
+                                                          Ops::and_(free_pawns, l.black_lanes),
+                                                          l.empty, enemies, check_mask));
+            moves = Ops::add(moves, Ops::andnot(l.pinned_moves, in_check));
+
+            // In double check only the king can move
+            V king_targets = king_attacks<Ops>(l.king);
+            moves = Ops::add(Ops::andnot(moves, double_check),
+                             Ops::popcount(Ops::andnot(king_targets, Ops::or_(l.own, l.king_danger))));
+
+            V own_pawn_attacks = Ops::select(l.black_lanes, black_pawn_attacks<Ops>(l.own_pawns),
+                                                            white_pawn_attacks<Ops>(l.own_pawns));
+            l.own_attacks = Ops::or_(l.own_attacks, Ops::or_(own_pawn_attacks,
+                Ops::or_(knight_attacks<Ops>(own_knights), king_targets)));
+
+            Ops::store(view.checkers + i, l.checkers);
+            Ops::store(view.pinned + i, l.pinned);
+
+            uint64_t own_out[Ops::LANES], enemy_out[Ops::LANES], count_out[Ops::LANES];
+            Ops::store(own_out, l.own_attacks);
+            Ops::store(enemy_out, l.enemy_attacks);
+            Ops::store(count_out, moves);
+            for (int lane = 0; lane < Ops::LANES; lane++) {
+                bool black = stm[lane];
+                view.attacks[WHITE][i + lane] = black ? enemy_out[lane] : own_out[lane];
+                view.attacks[BLACK][i + lane] = black ? own_out[lane] : enemy_out[lane];
+                view.legal_moves[i + lane] = static_cast<uint16_t>(count_out[lane]);
+            }
+        }
+    }
+}
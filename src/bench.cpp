@@ -0,0 +1,309 @@
+#include "bench.h"
+#include "batch.h"
+#include "board.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace Bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Position {
+    Board board;
+    MoveGen::CheckInfo info;
+    MoveList moves;
+};
+
+// Keep the compiler from discarding or hoisting a computation whose result
+// is otherwise unused
+template<typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+std::vector<Position> make_corpus() {
+    std::vector<Position> corpus;
+
+    auto add = [&](const Board& b) {
+        Position p;
+        p.board = b;
+        p.info = MoveGen::compute_check_info(b);
+        MoveGen::generate_legal_moves(b, p.moves);
+        corpus.push_back(p);
+    };
+
+    for (const std::string& fen : Search::bench_positions) {
+        Board root;
+        root.set_fen(fen);
+        add(root);
+
+        MoveList moves;
+        MoveGen::generate_legal_moves(root, moves);
+        for (const Move& m : moves) {
+            Board b = root;
+            b.make_move(m);
+            add(b);
+        }
+    }
+
+    return corpus;
+}
+
+// Time `pass` over the corpus: warm up for about 50 ms, then take `samples`
+// samples of as many passes as fit in about 20 ms
+template<typename Pass>
+Result measure(const char* name, size_t ops, int samples, Pass pass) {
+    Result r{name, ops, 0.0, 0.0, 0.0, {}};
+
+    auto warmup_end = Clock::now() + std::chrono::milliseconds(50);
+    int passes = 0;
+    while (Clock::now() < warmup_end) {
+        pass();
+        passes++;
+    }
+    int per_sample = std::max(passes * 20 / 50, 1);
+
+    for (int s = 0; s < samples; s++) {
+        auto start = Clock::now();
+        for (int i = 0; i < per_sample; i++)
+            pass();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        r.samples.push_back(ns / (double(per_sample) * ops));
+    }
+
+    double sum = 0.0, sq = 0.0;
+    for (double x : r.samples)
+        sum += x;
+    r.mean_ns = sum / r.samples.size();
+    for (double x : r.samples)
+        sq += (x - r.mean_ns) * (x - r.mean_ns);
+    r.stddev_ns = r.samples.size() > 1 ? std::sqrt(sq / (r.samples.size() - 1)) : 0.0;
+    r.min_ns = *std::min_element(r.samples.begin(), r.samples.end());
+    return r;
+}
+
+using Generator = void (*)(const Board&, const MoveGen::CheckInfo&, MoveList&);
+
+void print_table(const std::vector<Result>& results, std::ostream& out) {
+    char line[128];
+    std::snprintf(line, sizeof line, "%-26s %10s %10s %10s %8s %10s\n", "benchmark", "ops", "ns/op", "stddev", "cv", "min");
+    out << line;
+    for (const Result& r : results) {
+        std::snprintf(line, sizeof line, "%-26s %10zu %10.2f %10.3f %7.1f%% %10.2f\n", r.name.c_str(), r.ops,
+                      r.mean_ns, r.stddev_ns, r.mean_ns > 0 ? 100.0 * r.stddev_ns / r.mean_ns : 0.0, r.min_ns);
+        out << line;
+    }
+}
+
+} // namespace
+
+std::vector<Result> run(int samples, std::ostream& out) {
+    samples = std::max(samples, 2);
+    std::vector<Position> corpus = make_corpus();
+
+    size_t positions = corpus.size();
+    size_t legal_moves = 0;
+    for (const Position& p : corpus)
+        legal_moves += p.moves.size();
+
+    std::vector<Result> results;
+
+    // One call of the generator per position
+    auto generator = [&](const char* name, Generator generate) {
+        results.push_back(measure(name, positions, samples, [&] {
+            MoveList moves;
+            for (const Position& p : corpus) {
+                moves.clear();
+                generate(p.board, p.info, moves);
+                do_not_optimize(moves.count);
+            }
+        }));
+    };
+
+    generator("generate_pawn_moves", MoveGen::generate_pawn_moves);
+    generator("generate_knight_moves", MoveGen::generate_knight_moves);
+    generator("generate_bishop_moves", MoveGen::generate_bishop_moves);
+    generator("generate_rook_moves", MoveGen::generate_rook_moves);
+    generator("generate_queen_moves", MoveGen::generate_queen_moves);
+    generator("generate_castling_moves", MoveGen::generate_castling_moves);
+
+    // Every square, as attacked by the side not to move
+    results.push_back(measure("is_square_attacked", positions * 64, samples, [&] {
+        for (const Position& p : corpus) {
+            Color them = p.board.side_to_move == WHITE ? BLACK : WHITE;
+            for (int sq = 0; sq < 64; sq++)
+                do_not_optimize(MoveGen::is_square_attacked(p.board, sq, them));
+        }
+    }));
+
+    // Every legal move made and taken back
+    results.push_back(measure("make_move+unmake_move", legal_moves, samples, [&] {
+        for (Position& p : corpus) {
+            for (const Move& m : p.moves) {
+                StateInfo st;
+                p.board.make_move(m, st);
+                do_not_optimize(p.board.key);
+                p.board.unmake_move(m, st);
+            }
+        }
+    }));
+
+    // Both colors' and the total occupancy
+    results.push_back(measure("Board::occupied", positions * 3, samples, [&] {
+        for (const Position& p : corpus) {
+            do_not_optimize(p.board.occupied(WHITE));
+            do_not_optimize(p.board.occupied(BLACK));
+            do_not_optimize(p.board.occupied());
+        }
+    }));
+
+    // Legal move counts one position at a time, against the batch backends
+    // this CPU runs, each over the whole corpus in one call
+    results.push_back(measure("count_legal_moves", positions, samples, [&] {
+        for (const Position& p : corpus)
+            do_not_optimize(MoveGen::count_legal_moves(p.board));
+    }));
+
+    Batch::Positions batch;
+    for (const Position& p : corpus)
+        batch.push_back(p.board);
+    Batch::Results analysis;
+    size_t first_batch = results.size();
+    for (Batch::Backend backend : {Batch::SCALAR, Batch::AVX2, Batch::AVX512}) {
+        if (backend > Batch::best_backend())
+            continue;
+        std::string name = std::string("Batch::analyze/") + Batch::backend_name(backend);
+        results.push_back(measure(name.c_str(), positions, samples, [&] {
+            Batch::analyze(batch, analysis, backend);
+            do_not_optimize(analysis.legal_moves.data());
+        }));
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof line, "%zu positions, %zu legal moves, %d samples\n\n", positions, legal_moves, samples);
+    out << line;
+    print_table(results, out);
+
+    out << "\n";
+    for (size_t i = first_batch - 1; i < results.size(); i++) {
+        std::snprintf(line, sizeof line, "%-26s %8.2f M positions/s\n", results[i].name.c_str(), 1e3 / results[i].mean_ns);
+        out << line;
+    }
+
+    return results;
+}
+
+bool run_nnue(int samples, std::vector<Result>& results, std::ostream& out) {
+    samples = std::max(samples, 2);
+    std::vector<Position> corpus = make_corpus();
+
+    size_t legal_moves = 0;
+    for (const Position& p : corpus)
+        legal_moves += p.moves.size();
+
+    NNUE::Accumulator cached, uncached;
+    uncached.use_cache = false;
+
+    // Evaluate two plies below every position, so that king moves and the
+    // moves after them are covered, with the accumulator given or none
+    auto walk = [&](NNUE::Accumulator* acc) {
+        std::vector<int> evals;
+        for (const Position& p : corpus) {
+            Board b = p.board;
+            NNUE::attach(b, acc);
+            for (const Move& m : p.moves) {
+                StateInfo st;
+                b.make_move(m, st);
+                evals.push_back(NNUE::evaluate(b));
+
+                MoveList replies;
+                MoveGen::generate_legal_moves(b, replies);
+                for (const Move& r : replies) {
+                    StateInfo st2;
+                    b.make_move(r, st2);
+                    evals.push_back(NNUE::evaluate(b));
+                    b.unmake_move(r, st2);
+                }
+                b.unmake_move(m, st);
+            }
+        }
+        return evals;
+    };
+
+    std::vector<int> full = walk(nullptr);
+    bool consistent = walk(&cached) == full && walk(&uncached) == full;
+
+    // Make, evaluate and unmake every legal move, as a search does
+    auto eval_moves = [&](const char* name, NNUE::Accumulator* acc) {
+        results.push_back(measure(name, legal_moves, samples, [&] {
+            for (const Position& p : corpus) {
+                Board b = p.board;
+                NNUE::attach(b, acc);
+                for (const Move& m : p.moves) {
+                    StateInfo st;
+                    b.make_move(m, st);
+                    do_not_optimize(NNUE::evaluate(b));
+                    b.unmake_move(m, st);
+                }
+            }
+        }));
+    };
+
+    eval_moves("nnue incremental", &cached);
+    eval_moves("nnue incremental, no cache", &uncached);
+    eval_moves("nnue full recompute", nullptr);
+
+    char line[128];
+    std::snprintf(line, sizeof line, "%zu positions, %zu legal moves, %d samples, %s kernels\n",
+                  corpus.size(), legal_moves, samples, NNUE::KERNELS);
+    out << line;
+    std::snprintf(line, sizeof line, "%zu evaluations %s the full recomputation\n\n", full.size(),
+                  consistent ? "match" : "DO NOT match");
+    out << line;
+    print_table(results, out);
+
+    const Result& incremental = results[results.size() - 3];
+    const Result& recompute = results.back();
+    std::snprintf(line, sizeof line, "\nIncremental speedup over full recomputation: %.2fx\n",
+                  recompute.mean_ns / incremental.mean_ns);
+    out << line;
+
+    return consistent;
+}
+
+bool write_json(const std::vector<Result>& results, const std::string& path) {
+    std::ofstream f(path);
+    if (!f)
+        return false;
+
+    char buf[64];
+    auto num = [&](double x) {
+        std::snprintf(buf, sizeof buf, "%.4f", x);
+        return std::string(buf);
+    };
+
+    f << "{\n  \"unit\": \"ns/op\",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        f << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+          << ", \"mean\": " << num(r.mean_ns) << ", \"stddev\": " << num(r.stddev_ns)
+          << ", \"min\": " << num(r.min_ns) << ", \"samples\": [";
+        for (size_t s = 0; s < r.samples.size(); s++)
+            f << (s ? ", " : "") << num(r.samples[s]);
+        f << "]}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    f << "  ]\n}\n";
+
+    return static_cast<bool>(f);
+}
+
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Microbenchmarks of the individual move generation primitives, for catching
+// per-function regressions that a whole-tree perft total hides. Every
+// benchmark runs over the same fixed corpus: the search bench positions and
+// every position one legal move away from them.
+namespace Bench {
+    struct Result {
+        std::string name;
+        size_t ops;                  // Operations per pass over the corpus
+        double mean_ns;              // Per operation, over the samples
+        double stddev_ns;
+        double min_ns;
+        std::vector<double> samples; // ns/op of each sample
+    };
+
+    // Warm up, then time `samples` samples of each benchmark, each sample
+    // long enough (about 20 ms) for the clock resolution not to matter.
+    // A table of the results is written to out, followed by the positions
+    // per second of count_legal_moves and of each Batch::analyze backend.
+    std::vector<Result> run(int samples, std::ostream& out = std::cout);
+
+    // Network evaluation after each legal move of the corpus, with the
+    // accumulator updated incrementally (with and without the king-square
+    // cache) and recomputed from scratch. Needs a loaded network. Returns
+    // false if the incremental evaluations differ from the full ones.
+    bool run_nnue(int samples, std::vector<Result>& results, std::ostream& out = std::cout);
+
+    // The results as a JSON document, for diffing between commits
+    bool write_json(const std::vector<Result>& results, const std::string& path);
+}
@@ -0,0 +1,177 @@
+#include "bitbase.h"
+#include "movegen.h"
+#include "worksteal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Bitbases {
+
+namespace {
+
+// stm (1 bit), black king (6), white king (6), pawn file a-d (2), pawn rank 7-2 (0-5)
+constexpr int MAX_INDEX = 2 * 24 * 64 * 64;
+constexpr int CHUNK = 4096;
+
+uint64_t kpk[MAX_INDEX / 64];
+std::once_flag generated;
+
+// Bit flags, so the results of all moves can be or-ed together
+enum Result : uint8_t {
+    INVALID = 0,
+    UNKNOWN = 1,
+    DRAW    = 2,
+    WIN     = 4
+};
+
+constexpr int index(Color stm, int bksq, int wksq, int psq) {
+    return stm | (bksq << 1) | (wksq << 7) | ((psq & 7) << 13) | ((6 - psq / 8) << 15);
+}
+
+constexpr Bitboard bb(int sq) { return 1ULL << sq; }
+
+struct KPKPosition {
+    Color stm;
+    int wksq, bksq, psq;
+
+    explicit KPKPosition(int idx)
+        : stm(static_cast<Color>(idx & 1)),
+          wksq((idx >> 7) & 63),
+          bksq((idx >> 1) & 63),
+          psq(8 * (6 - (idx >> 15)) + ((idx >> 13) & 3)) {}
+
+    // What can be decided without looking at the successors
+    Result initial() const {
+        using MoveGen::king_attacks;
+        using MoveGen::pawn_attacks;
+
+        // Kings touching, a king on the pawn, or the pawn side to move with
+        // the black king in check
+        if ((king_attacks[wksq] & bb(bksq)) || wksq == psq || bksq == psq ||
+            (stm == WHITE && (pawn_attacks[WHITE][psq] & bb(bksq))))
+            return INVALID;
+
+        // The pawn promotes and the new queen cannot be taken at once
+        int push = psq + 8;
+        if (stm == WHITE && psq / 8 == 6 && wksq != push && bksq != push &&
+            (!(king_attacks[bksq] & bb(push)) || (king_attacks[wksq] & bb(push))))
+            return WIN;
+
+        // Stalemate, or the pawn is lost
+        if (stm == BLACK &&
+            (!(king_attacks[bksq] & ~(king_attacks[wksq] | pawn_attacks[WHITE][psq])) ||
+             (king_attacks[bksq] & bb(psq) & ~king_attacks[wksq])))
+            return DRAW;
+
+        return UNKNOWN;
+    }
+
+    // Combine the successors' results: white wins if some move wins, black
+    // draws if some move draws. Moves into an illegal position read INVALID,
+    // which adds nothing.
+    Result classify(const uint8_t* db) const {
+        auto load = [&](int idx) {
+            return std::atomic_ref<const uint8_t>(db[idx]).load(std::memory_order_relaxed);
+        };
+
+        const Result good = stm == WHITE ? WIN : DRAW;
+        const Result bad  = stm == WHITE ? DRAW : WIN;
+        int r = INVALID;
+
+        Bitboard b = MoveGen::king_attacks[stm == WHITE ? wksq : bksq];
+        while (b) {
+            int to = Bitboards::lsb(b);
+            Bitboards::clear_bit(b, to);
+            r |= stm == WHITE ? load(index(BLACK, bksq, to, psq)) : load(index(WHITE, to, wksq, psq));
+        }
+
+        if (stm == WHITE) {
+            int push = psq + 8;
+            if (psq / 8 < 6)
+                r |= load(index(BLACK, bksq, wksq, push));
+            if (psq / 8 == 1 && push != wksq && push != bksq)
+                r |= load(index(BLACK, bksq, wksq, push + 8));
+        }
+
+        return (r & good) ? good : (r & UNKNOWN) ? UNKNOWN : bad;
+    }
+};
+
+// Fixed-point iteration over the index space, cut into chunks that the
+// threads share through WorkStealing::run. Results only ever move from
+// UNKNOWN to WIN or DRAW, and the fixed point is unique, so threads may read
+// each other's updates mid-pass in any order: a pass that sees more resolved
+// positions just converges sooner.
+void generate(int threads) {
+    std::vector<uint8_t> db(MAX_INDEX);
+    const size_t chunks = MAX_INDEX / CHUNK;
+
+    WorkStealing::run(chunks, threads, [&](size_t chunk, int) {
+        for (int idx = chunk * CHUNK; idx < int(chunk + 1) * CHUNK; idx++)
+            db[idx] = KPKPosition(idx).initial();
+    });
+
+    std::atomic<bool> changed = true;
+    while (changed) {
+        changed = false;
+        WorkStealing::run(chunks, threads, [&](size_t chunk, int) {
+            bool any = false;
+            for (int idx = chunk * CHUNK; idx < int(chunk + 1) * CHUNK; idx++) {
+                std::atomic_ref<uint8_t> slot(db[idx]);
+                if (slot.load(std::memory_order_relaxed) != UNKNOWN)
+                    continue;
+                Result r = KPKPosition(idx).classify(db.data());
+                if (r != UNKNOWN) {
+                    slot.store(r, std::memory_order_relaxed);
+                    any = true;
+                }
+            }
+            if (any)
+                changed = true;
+        });
+    }
+
+    // Unresolved positions are draws: neither side can force anything
+    for (int idx = 0; idx < MAX_INDEX; idx++)
+        if (db[idx] == WIN)
+            kpk[idx / 64] |= 1ULL << (idx % 64);
+}
+
+} // namespace
+
+void init(int threads) {
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    std::call_once(generated, generate, threads);
+}
+
+bool probe_kpk(int wksq, int wpsq, int bksq, Color stm) {
+    // The table only holds pawns on files a-d; mirror the others
+    if ((wpsq & 7) >= 4) {
+        wksq ^= 7;
+        wpsq ^= 7;
+        bksq ^= 7;
+    }
+    int idx = index(stm, bksq, wksq, wpsq);
+    return kpk[idx / 64] & (1ULL << (idx % 64));
+}
+
+bool probe_kpk(const Board& board, Color strong) {
+    Color weak = strong == WHITE ? BLACK : WHITE;
+    int wksq = Bitboards::lsb(board.pieces(strong, KING));
+    int wpsq = Bitboards::lsb(board.pieces(strong, PAWN));
+    int bksq = Bitboards::lsb(board.pieces(weak, KING));
+
+    // Seen from the pawn side, which the table calls white
+    if (strong == BLACK) {
+        wksq ^= 56;
+        wpsq ^= 56;
+        bksq ^= 56;
+    }
+    return probe_kpk(wksq, wpsq, bksq, board.side_to_move == strong ? WHITE : BLACK);
+}
+
+}
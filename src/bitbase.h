@@ -0,0 +1,21 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+// King and pawn vs king bitbase: one bit per position, set if the pawn side
+// wins. The 196608 positions (both sides to move, pawn on files a-d, the
+// other files by symmetry) take 24 KB and are found by retrograde analysis
+// when the program starts.
+namespace Bitbases {
+    // Generate the bitbase on `threads` threads. Calls after the first
+    // return at once.
+    void init(int threads = 0);
+
+    // Whether white wins with king on wksq and pawn on wpsq against the black
+    // king on bksq, `stm` to move. The pawn may be on any file.
+    bool probe_kpk(int wksq, int wpsq, int bksq, Color stm);
+
+    // The same for a board holding only the kings and one pawn of `strong`
+    bool probe_kpk(const Board& board, Color strong);
+}
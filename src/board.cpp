@@ -1,4 +1,9 @@
 #include "board.h"
+#include "nnue.h"
+#include "stats.h"
+
+#include <cctype>
+#include <sstream>
 
 // Constructor initializes to start position
 Board::Board() {
@@ -7,29 +12,28 @@ Board::Board() {
 
 // Initialize standard chess starting position
 void Board::init_startpos() {
-    // Pawns
-    pieces[WHITE][PAWN]   = 0x000000000000FF00ULL;
-    pieces[BLACK][PAWN]   = 0x00FF000000000000ULL;
-
-    // Knights
-    pieces[WHITE][KNIGHT] = 0x0000000000000042ULL;
-    pieces[BLACK][KNIGHT] = 0x4200000000000000ULL;
+    if (accumulator)
+        accumulator->dirty[WHITE] = accumulator->dirty[BLACK] = true;
 
-    // Bishops
-    pieces[WHITE][BISHOP] = 0x0000000000000024ULL;
-    pieces[BLACK][BISHOP] = 0x2400000000000000ULL;
+    by_type[PAWN]   = 0x00FF00000000FF00ULL;
+    by_type[KNIGHT] = 0x4200000000000042ULL;
+    by_type[BISHOP] = 0x2400000000000024ULL;
+    by_type[ROOK]   = 0x8100000000000081ULL;
+    by_type[QUEEN]  = 0x0800000000000008ULL;
+    by_type[KING]   = 0x1000000000000010ULL;
 
-    // Rooks
-    pieces[WHITE][ROOK]   = 0x0000000000000081ULL;
-    pieces[BLACK][ROOK]   = 0x8100000000000000ULL;
+    by_color[WHITE] = 0x000000000000FFFFULL;
+    by_color[BLACK] = 0xFFFF000000000000ULL;
+    by_type[ALL_PIECES] = by_color[WHITE] | by_color[BLACK];
 
-    // Queens
-    pieces[WHITE][QUEEN]  = 0x0000000000000008ULL;
-    pieces[BLACK][QUEEN]  = 0x0800000000000000ULL;
-
-    // Kings
-    pieces[WHITE][KING]   = 0x0000000000000010ULL;
-    pieces[BLACK][KING]   = 0x1000000000000000ULL;
+    // Fill the mailbox from the bitboards
+    for (int sq = 0; sq < 64; sq++) {
+        board[sq] = NO_PIECE;
+        for (int piece = PAWN; piece < PIECE_NB; piece++) {
+            if (Bitboards::get_bit(by_type[piece], sq))
+                board[sq] = static_cast<Piece>(piece);
+        }
+    }
 
     side_to_move = WHITE;
 
@@ -38,69 +42,422 @@ void Board::init_startpos() {
 
     // No en passant square at start
     en_passant_square = -1;
+
+    halfmove_clock = 0;
+    fullmove_number = 1;
+
+    key = compute_key();
+    pawn_key = compute_pawn_key();
+    compute_psq();
 }
 
-// Make a move on the board
-bool Board::make_move(const Move &move) {
-    Color us = side_to_move;
-    Color them = (us == WHITE) ? BLACK : WHITE;
+// Parsed into a scratch board, so that a rejected FEN leaves this one as it was
+bool Board::set_fen(const std::string &fen) {
+    std::istringstream ss(fen);
+    std::string placement, side, castling, ep;
 
-    Piece moved_piece = NO_PIECE;
+    if (!(ss >> placement >> side >> castling >> ep))
+        return false;
 
-    // Find moved piece
-    for (int p = PAWN; p < PIECE_NB; ++p) {
-        if (Bitboards::get_bit(pieces[us][p], move.from)) {
-            moved_piece = static_cast<Piece>(p);
-            Bitboards::clear_bit(pieces[us][moved_piece], move.from);
-            break;
+    Board b;
+    for (int p = ALL_PIECES; p < PIECE_NB; p++)
+        b.by_type[p] = EMPTY_BITBOARD;
+    b.by_color[WHITE] = b.by_color[BLACK] = EMPTY_BITBOARD;
+    for (int sq = 0; sq < 64; sq++)
+        b.board[sq] = NO_PIECE;
+
+    // Piece placement, rank 8 first, each rank covering exactly 8 files
+    const std::string piece_chars = ".pnbrqk";
+    int rank = 7, file = 0;
+    for (char ch : placement) {
+        if (ch == '/') {
+            if (file != 8 || rank == 0)
+                return false;
+            rank--;
+            file = 0;
+        } else if (ch >= '1' && ch <= '8') {
+            file += ch - '0';
+            if (file > 8)
+                return false;
+        } else {
+            size_t p = piece_chars.find(static_cast<char>(std::tolower(ch)));
+            if (p == std::string::npos || p == 0 || file > 7)
+                return false;
+            Color c = std::isupper(static_cast<unsigned char>(ch)) ? WHITE : BLACK;
+            Piece piece = static_cast<Piece>(p);
+            if (piece == PAWN && (rank == 0 || rank == 7))
+                return false;
+            Bitboard bit = 1ULL << (rank * 8 + file);
+            b.by_type[piece] |= bit;
+            b.by_type[ALL_PIECES] |= bit;
+            b.by_color[c] |= bit;
+            b.board[rank * 8 + file] = piece;
+            file++;
         }
     }
+    if (rank != 0 || file != 8)
+        return false;
+
+    if (Bitboards::popcount(b.pieces(WHITE, KING)) != 1 || Bitboards::popcount(b.pieces(BLACK, KING)) != 1)
+        return false;
 
-    // Handle en passant captures FIRST clearly:
-    if (moved_piece == PAWN && move.to == en_passant_square) {
-        // Explicitly calculate the captured pawn's square
-        int ep_captured_square = move.to + ((us == WHITE) ? -8 : 8);
-        Bitboards::clear_bit(pieces[them][PAWN], ep_captured_square);
+    if (side == "w")
+        b.side_to_move = WHITE;
+    else if (side == "b")
+        b.side_to_move = BLACK;
+    else
+        return false;
+
+    b.castling_rights = 0;
+    for (char ch : castling) {
+        switch (ch) {
+            case 'K': b.castling_rights |= 1; break;
+            case 'Q': b.castling_rights |= 2; break;
+            case 'k': b.castling_rights |= 4; break;
+            case 'q': b.castling_rights |= 8; break;
+            case '-': break;
+            default: return false;
+        }
+    }
+
+    // A right only stands while its king and rook are on their home squares
+    struct { int right; Color c; int king, rook; } homes[] = {
+        { 1, WHITE, 4, 7 }, { 2, WHITE, 4, 0 }, { 4, BLACK, 60, 63 }, { 8, BLACK, 60, 56 }
+    };
+    for (const auto& h : homes)
+        if (!Bitboards::get_bit(b.pieces(h.c, KING), h.king) || !Bitboards::get_bit(b.pieces(h.c, ROOK), h.rook))
+            b.castling_rights &= ~h.right;
+
+    // The square behind a pawn the opponent just pushed two squares
+    char ep_rank = b.side_to_move == WHITE ? '6' : '3';
+    if (ep == "-") {
+        b.en_passant_square = -1;
+    } else if (ep.size() == 2 && ep[0] >= 'a' && ep[0] <= 'h' && ep[1] == ep_rank) {
+        b.en_passant_square = (ep[1] - '1') * 8 + (ep[0] - 'a');
     } else {
-        // Regular captures explicitly handled
-        for (int p = PAWN; p < PIECE_NB; ++p) {
-            if (Bitboards::get_bit(pieces[them][p], move.to)) {
-                Bitboards::clear_bit(pieces[them][p], move.to);
-                break;
+        return false;
+    }
+
+    // Optional move counters (absent in EPD)
+    b.halfmove_clock = 0;
+    b.fullmove_number = 1;
+    int counter;
+    if (ss >> counter) {
+        b.halfmove_clock = counter;
+        if (ss >> counter)
+            b.fullmove_number = counter;
+    }
+
+    b.key = b.compute_key();
+    b.pawn_key = b.compute_pawn_key();
+    b.compute_psq();
+
+    b.accumulator = accumulator;
+    *this = b;
+    if (accumulator)
+        accumulator->dirty[WHITE] = accumulator->dirty[BLACK] = true;
+    return true;
+}
+
+std::string Board::fen() const {
+    const char piece_chars[COLOR_NB][PIECE_NB] = {
+        { '.', 'P', 'N', 'B', 'R', 'Q', 'K' },
+        { '.', 'p', 'n', 'b', 'r', 'q', 'k' }
+    };
+
+    std::string s;
+    for (int rank = 7; rank >= 0; rank--) {
+        int empty = 0;
+        for (int file = 0; file < 8; file++) {
+            int sq = rank * 8 + file;
+            if (board[sq] == NO_PIECE) {
+                empty++;
+                continue;
             }
+            if (empty) {
+                s += static_cast<char>('0' + empty);
+                empty = 0;
+            }
+            Color c = Bitboards::get_bit(occupied(WHITE), sq) ? WHITE : BLACK;
+            s += piece_chars[c][board[sq]];
         }
+        if (empty)
+            s += static_cast<char>('0' + empty);
+        if (rank > 0)
+            s += '/';
     }
 
-    // Set moved piece clearly (handle promotions explicitly too)
-    Piece final_piece = move.promotion == NO_PIECE ? moved_piece : move.promotion;
-    Bitboards::set_bit(pieces[us][final_piece], move.to);
+    s += (side_to_move == WHITE) ? " w " : " b ";
+
+    if (castling_rights & 1) s += 'K';
+    if (castling_rights & 2) s += 'Q';
+    if (castling_rights & 4) s += 'k';
+    if (castling_rights & 8) s += 'q';
+    if (castling_rights == 0) s += '-';
+
+    s += ' ';
+    if (en_passant_square == -1)
+        s += '-';
+    else
+        s += std::string{static_cast<char>('a' + en_passant_square % 8), static_cast<char>('1' + en_passant_square / 8)};
+
+    s += ' ' + std::to_string(halfmove_clock) + ' ' + std::to_string(fullmove_number);
+    return s;
+}
+
+// Make a move on the board
+bool Board::make_move(const Move &move) {
+    StateInfo st;
+    return make_move(move, st);
+}
+
+// Make a move on the board, recording the irreversible state in st
+bool Board::make_move(const Move &move, StateInfo &st) {
+    STATS_INC(MAKE_MOVE);
+    STATS_TIME(DO_MOVE);
+
+    Color us = side_to_move;
+    Color them = (us == WHITE) ? BLACK : WHITE;
 
-    // Clearly update castling rights
-    update_castling_rights(move.from);
-    update_castling_rights(move.to);
+    int from = move.from();
+    int to = move.to();
+    int flags = move.flags();
+    Piece moved_piece = board[from];
 
-    // En passant square clearly updated:
-    if (moved_piece == PAWN && abs(move.to - move.from) == 16) {
-        en_passant_square = (move.from + move.to) / 2;
+    st.castling_rights = castling_rights;
+    st.en_passant_square = en_passant_square;
+    st.halfmove_clock = halfmove_clock;
+    st.captured = NO_PIECE;
+    st.key = key;
+
+    // Pieces are hashed by put/remove/move_piece, the rest is handled here
+    if (en_passant_square != -1)
+        key ^= Zobrist::en_passant[en_passant_square % 8];
+    key ^= Zobrist::castling[castling_rights];
+    en_passant_square = -1;
+
+    // Remove the captured piece; en passant takes a pawn that is not on the destination square
+    if (flags == EN_PASSANT) {
+        remove_piece(them, to + ((us == WHITE) ? -8 : 8));
+        st.captured = PAWN;
+    } else if (move.is_capture()) {
+        st.captured = board[to];
+        remove_piece(them, to);
+    }
+
+    // Move the piece, swapping in the promoted piece if any
+    if (move.is_promotion()) {
+        remove_piece(us, from);
+        put_piece(us, move.promotion(), to);
     } else {
-        en_passant_square = -1;
+        move_piece(us, from, to);
     }
 
+    switch (flags) {
+        case DOUBLE_PUSH:
+            en_passant_square = (from + to) / 2;
+            key ^= Zobrist::en_passant[en_passant_square % 8];
+            break;
+        case KING_CASTLE:   // Rook h-file -> f-file
+            move_piece(us, from + 3, from + 1);
+            break;
+        case QUEEN_CASTLE:  // Rook a-file -> d-file
+            move_piece(us, from - 4, from - 1);
+            break;
+    }
+
+    // Update castling rights
+    update_castling_rights(from);
+    update_castling_rights(to);
+
+    key ^= Zobrist::castling[castling_rights];
+    key ^= Zobrist::side;
+
+    // Move counters
+    if (moved_piece == PAWN || st.captured != NO_PIECE)
+        halfmove_clock = 0;
+    else
+        halfmove_clock++;
+    if (us == BLACK)
+        fullmove_number++;
+
     side_to_move = them;
     return true;
 }
 
-// Return occupied squares by a specific color
-Bitboard Board::occupied(Color c) const {
-    Bitboard occ = EMPTY_BITBOARD;
-    for (int p = PAWN; p < PIECE_NB; p++)
-        occ |= pieces[c][p];
-    return occ;
+// Take back a move, restoring the captured piece and the saved state
+void Board::unmake_move(const Move &move, const StateInfo &st) {
+    STATS_INC(UNMAKE_MOVE);
+    STATS_TIME(UNDO_MOVE);
+
+    Color them = side_to_move;
+    Color us = (them == WHITE) ? BLACK : WHITE;
+
+    int from = move.from();
+    int to = move.to();
+    int flags = move.flags();
+
+    side_to_move = us;
+    castling_rights = st.castling_rights;
+    en_passant_square = st.en_passant_square;
+    halfmove_clock = st.halfmove_clock;
+    if (us == BLACK)
+        fullmove_number--;
+
+    // Put the moving piece back, undoing any promotion
+    if (move.is_promotion()) {
+        remove_piece(us, to);
+        put_piece(us, PAWN, from);
+    } else {
+        move_piece(us, to, from);
+    }
+
+    switch (flags) {
+        case KING_CASTLE:
+            move_piece(us, from + 1, from + 3);
+            break;
+        case QUEEN_CASTLE:
+            move_piece(us, from - 1, from - 4);
+            break;
+        case EN_PASSANT:
+            put_piece(them, PAWN, to + ((us == WHITE) ? -8 : 8));
+            break;
+        default:
+            if (st.captured != NO_PIECE)
+                put_piece(them, st.captured, to);
+            break;
+    }
+
+    key = st.key;
+}
+
+// Pass the turn: only the side to move and the en passant square change
+void Board::make_null_move(StateInfo &st) {
+    st.castling_rights = castling_rights;
+    st.en_passant_square = en_passant_square;
+    st.halfmove_clock = halfmove_clock;
+    st.captured = NO_PIECE;
+    st.key = key;
+
+    if (en_passant_square != -1)
+        key ^= Zobrist::en_passant[en_passant_square % 8];
+    key ^= Zobrist::side;
+    en_passant_square = -1;
+    halfmove_clock++;
+
+    side_to_move = (side_to_move == WHITE) ? BLACK : WHITE;
+}
+
+void Board::unmake_null_move(const StateInfo &st) {
+    side_to_move = (side_to_move == WHITE) ? BLACK : WHITE;
+    en_passant_square = st.en_passant_square;
+    halfmove_clock = st.halfmove_clock;
+    key = st.key;
+}
+
+void Board::put_piece(Color c, Piece p, int square) {
+    Bitboard bit = 1ULL << square;
+    by_type[p] |= bit;
+    by_type[ALL_PIECES] |= bit;
+    by_color[c] |= bit;
+    board[square] = p;
+    key ^= Zobrist::psq[c][p][square];
+    if (p == PAWN)
+        pawn_key ^= Zobrist::psq[c][p][square];
+    psq_mg += PSQT::mg[c][p][square];
+    psq_eg += PSQT::eg[c][p][square];
+    phase += PSQT::phase_weight[p];
+    if (accumulator)
+        accumulator->put_piece(*this, c, p, square);
+}
+
+void Board::remove_piece(Color c, int square) {
+    Piece p = board[square];
+    Bitboard bit = 1ULL << square;
+    by_type[p] ^= bit;
+    by_type[ALL_PIECES] ^= bit;
+    by_color[c] ^= bit;
+    board[square] = NO_PIECE;
+    key ^= Zobrist::psq[c][p][square];
+    if (p == PAWN)
+        pawn_key ^= Zobrist::psq[c][p][square];
+    psq_mg -= PSQT::mg[c][p][square];
+    psq_eg -= PSQT::eg[c][p][square];
+    phase -= PSQT::phase_weight[p];
+    if (accumulator)
+        accumulator->remove_piece(*this, c, p, square);
+}
+
+void Board::move_piece(Color c, int from, int to) {
+    Piece p = board[from];
+    Bitboard from_to = (1ULL << from) | (1ULL << to);
+    by_type[p] ^= from_to;
+    by_type[ALL_PIECES] ^= from_to;
+    by_color[c] ^= from_to;
+    board[from] = NO_PIECE;
+    board[to] = p;
+    key ^= Zobrist::psq[c][p][from] ^ Zobrist::psq[c][p][to];
+    if (p == PAWN)
+        pawn_key ^= Zobrist::psq[c][p][from] ^ Zobrist::psq[c][p][to];
+    psq_mg += PSQT::mg[c][p][to] - PSQT::mg[c][p][from];
+    psq_eg += PSQT::eg[c][p][to] - PSQT::eg[c][p][from];
+    if (accumulator)
+        accumulator->move_piece(*this, c, p, from, to);
+}
+
+uint64_t Board::compute_key() const {
+    uint64_t k = 0ULL;
+
+    for (int c = WHITE; c <= BLACK; c++) {
+        for (int p = PAWN; p < PIECE_NB; p++) {
+            Bitboard bb = pieces(static_cast<Color>(c), static_cast<Piece>(p));
+            while (bb) {
+                int sq = Bitboards::lsb(bb);
+                k ^= Zobrist::psq[c][p][sq];
+                Bitboards::clear_bit(bb, sq);
+            }
+        }
+    }
+
+    k ^= Zobrist::castling[castling_rights];
+    if (en_passant_square != -1)
+        k ^= Zobrist::en_passant[en_passant_square % 8];
+    if (side_to_move == BLACK)
+        k ^= Zobrist::side;
+
+    return k;
+}
+
+uint64_t Board::compute_pawn_key() const {
+    uint64_t k = 0ULL;
+
+    for (int c = WHITE; c <= BLACK; c++) {
+        Bitboard bb = pieces(static_cast<Color>(c), PAWN);
+        while (bb) {
+            int sq = Bitboards::lsb(bb);
+            k ^= Zobrist::psq[c][PAWN][sq];
+            Bitboards::clear_bit(bb, sq);
+        }
+    }
+
+    return k;
 }
 
-// Return occupied squares for both colors
-Bitboard Board::occupied() const {
-    return occupied(WHITE) | occupied(BLACK);
+void Board::compute_psq() {
+    psq_mg = psq_eg = phase = 0;
+
+    for (int c = WHITE; c <= BLACK; c++) {
+        for (int p = PAWN; p < PIECE_NB; p++) {
+            Bitboard bb = pieces(static_cast<Color>(c), static_cast<Piece>(p));
+            while (bb) {
+                int sq = Bitboards::lsb(bb);
+                psq_mg += PSQT::mg[c][p][sq];
+                psq_eg += PSQT::eg[c][p][sq];
+                phase += PSQT::phase_weight[p];
+                Bitboards::clear_bit(bb, sq);
+            }
+        }
+    }
 }
 
 void Board::update_castling_rights(int from_square) {
@@ -137,16 +494,8 @@ void Board::print() const {
         std::cout << (rank + 1) << " ";
         for (int file = 0; file < 8; file++) {
             int sq = rank * 8 + file;
-            char piece_char = '.';
-
-            // Find which piece is at this square (if any)
-            for (int color = WHITE; color <= BLACK; color++) {
-                for (int piece = PAWN; piece < PIECE_NB; piece++) {
-                    if (Bitboards::get_bit(pieces[color][piece], sq)) {
-                        piece_char = piece_chars[color][piece];
-                    }
-                }
-            }
+            Color color = Bitboards::get_bit(occupied(WHITE), sq) ? WHITE : BLACK;
+            char piece_char = piece_chars[color][board[sq]];
             std::cout << piece_char << " ";
         }
         std::cout << "\n";
@@ -2,13 +2,34 @@
 
 #include "types.h"
 #include "bitboard.h"
+#include "zobrist.h"
+#include "psqt.h"
 
 #include <array>
 #include <iostream>
+#include <string>
+
+namespace NNUE { struct Accumulator; }
+
+// Irreversible state saved by make_move, so that unmake_move can restore it
+struct StateInfo {
+    int castling_rights;
+    int en_passant_square;
+    int halfmove_clock;
+    Piece captured;  // NO_PIECE if the move was not a capture
+    uint64_t key;    // Zobrist key before the move
+};
 
 struct Board {
-    // Array of bitboards [color][piece] representing positions.
-    Bitboard pieces[COLOR_NB][PIECE_NB];
+    // Pieces of each type of both colors, with every occupied square in
+    // by_type[ALL_PIECES], and all pieces of each color. A piece of color c
+    // and type p is in by_color[c] & by_type[p]. Kept up to date by
+    // put/remove/move_piece, so occupancy never has to be recomputed.
+    Bitboard by_type[PIECE_NB];
+    Bitboard by_color[COLOR_NB];
+
+    // Piece type on each square (NO_PIECE if empty), kept in sync with pieces
+    Piece board[64];
 
     // Side to move (WHITE or BLACK)
     Color side_to_move;
@@ -19,20 +40,76 @@ struct Board {
     // En passant square (-1 if none, otherwise 0-63)
     int en_passant_square;
 
+    // Plies since the last capture or pawn move, and the move number
+    int halfmove_clock;
+    int fullmove_number;
+
+    // Zobrist key of the position, updated incrementally by make_move
+    uint64_t key;
+
+    // Zobrist key of the pawns alone, indexing the pawn hash table
+    uint64_t pawn_key;
+
+    // Material plus piece-square sums from white's point of view, for the
+    // middlegame and the endgame, and the game phase (PSQT::MAX_PHASE with
+    // all pieces on). Kept up to date by put/remove/move_piece.
+    int psq_mg;
+    int psq_eg;
+    int phase;
+
+    // Network accumulator updated by put/remove/move_piece, if one is
+    // attached (NNUE::attach). Copies of the board share it, so a board
+    // handed to another thread must be given its own or none.
+    NNUE::Accumulator* accumulator = nullptr;
+
     // Constructor
     Board();
 
     // Initialize board to standard chess starting position
     void init_startpos();
 
+    // Set up a position from FEN. The move counters are optional, so EPD
+    // records can be passed as-is. Returns false on malformed input.
+    bool set_fen(const std::string& fen);
+
+    // Serialize the position to FEN
+    std::string fen() const;
+
     // Make a move on the board
     bool make_move(const Move& move);
 
+    // Make a move, saving what is needed to take it back into st
+    bool make_move(const Move& move, StateInfo& st);
+
+    // Take back a move made with make_move(move, st)
+    void unmake_move(const Move& move, const StateInfo& st);
+
+    // Pass the turn without moving (null-move pruning). Must not be called in check.
+    void make_null_move(StateInfo& st);
+    void unmake_null_move(const StateInfo& st);
+
+    // Place, remove or relocate a piece, updating both bitboards and mailbox
+    void put_piece(Color c, Piece p, int square);
+    void remove_piece(Color c, int square);
+    void move_piece(Color c, int from, int to);
+
+    Bitboard pieces(Color c, Piece p) const { return by_color[c] & by_type[p]; }
+    Bitboard pieces(Color c, Piece p1, Piece p2) const { return by_color[c] & (by_type[p1] | by_type[p2]); }
+
     // Get occupied squares for one color
-    Bitboard occupied(Color c) const;
+    Bitboard occupied(Color c) const { return by_color[c]; }
 
     // Get occupied squares (both colors)
-    Bitboard occupied() const;
+    Bitboard occupied() const { return by_type[ALL_PIECES]; }
+
+    int king_square(Color c) const { return Bitboards::lsb(pieces(c, KING)); }
+
+    // Compute the Zobrist keys from scratch
+    uint64_t compute_key() const;
+    uint64_t compute_pawn_key() const;
+
+    // Recompute psq_mg, psq_eg and phase from scratch
+    void compute_psq();
 
     // Update castling rights after a move
     void update_castling_rights(int from_square);
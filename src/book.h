@@ -0,0 +1,75 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Polyglot opening books. A book is an array of 16-byte big-endian entries
+// sorted by position key; it is memory-mapped and binary-searched in place,
+// so opening even a multi-hundred-MB book costs nothing up front.
+//
+// The position key is Polyglot's own Zobrist hash, built from the 781
+// Random64 constants of the Polyglot specification.
+namespace Book {
+    constexpr int RANDOM_NB = 781;
+
+    // Polyglot key of the position
+    uint64_t key(const Board& board);
+
+    struct BookMove {
+        Move move;
+        int weight;
+    };
+
+    class PolyglotBook {
+    public:
+        PolyglotBook() = default;
+        ~PolyglotBook() { close(); }
+        PolyglotBook(const PolyglotBook&) = delete;
+        PolyglotBook& operator=(const PolyglotBook&) = delete;
+
+        // Returns false if the file cannot be mapped or its size is not a
+        // multiple of the entry size
+        bool open(const std::string& path);
+        void close();
+
+        size_t size() const { return count; }
+
+        // The book moves of the position that are legal in it, highest weight first
+        std::vector<BookMove> probe(const Board& board) const;
+
+        // Highest-weight book move, or Move::none()
+        Move best_move(const Board& board) const;
+
+        // best_move of count positions. The keys are sorted first, so the
+        // searches walk the book in one direction and each one starts where
+        // the previous one ended.
+        void probe_batch(const Board* boards, size_t count, Move* moves) const;
+
+    private:
+        struct Entry {
+            uint64_t key;     // All fields big-endian
+            uint16_t move;
+            uint16_t weight;
+            uint32_t learn;
+        };
+
+        static_assert(sizeof(Entry) == 16, "Polyglot entries are 16 bytes");
+
+        // First entry in [first, count) whose key is not below `key`
+        size_t lower_bound(uint64_t key, size_t first) const;
+        Move best_from(const Board& board, size_t index, uint64_t key) const;
+
+        const Entry* entries = nullptr;
+        size_t count = 0;
+        size_t length = 0;
+    };
+
+    // The legal move a Polyglot move encodes, or Move::none(). Polyglot writes
+    // castling as the king capturing its own rook.
+    Move decode_move(const Board& board, uint16_t move);
+}
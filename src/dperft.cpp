@@ -0,0 +1,289 @@
+#include "dperft.h"
+#include "movegen.h"
+#include "perft.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace DistPerft {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct Job {
+    std::string fen;
+    int depth = 0;
+    int split_depth = 0;
+    size_t units = 0;
+};
+
+struct Unit {
+    std::string fen;
+    uint64_t multiplicity = 0;
+};
+
+// Write through a temporary file and rename it into place, so readers see
+// either nothing or the whole file
+bool write_atomic(const fs::path& path, const std::string& text) {
+    fs::path tmp = path;
+    tmp += ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream f(tmp);
+        if (!(f << text) || !f.flush())
+            return false;
+    }
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
+
+bool read_job(const fs::path& path, Job& job) {
+    std::ifstream f(path);
+    std::string key;
+    while (f >> key) {
+        if (key == "fen")         { f >> std::ws; std::getline(f, job.fen); }
+        else if (key == "depth")  f >> job.depth;
+        else if (key == "split")  f >> job.split_depth;
+        else if (key == "units")  f >> job.units;
+    }
+    return !job.fen.empty() && job.units > 0;
+}
+
+// Placement, side to move, castling and en passant: the fields perft
+// depends on, so positions differing only in the move clocks merge
+std::string position_key(const std::string& fen) {
+    std::istringstream is(fen);
+    std::string field, key;
+    for (int i = 0; i < 4 && is >> field; i++)
+        key += field + " ";
+    return key;
+}
+
+// Collect the distinct positions split_depth plies below board, counting
+// the move orders that reach each one
+void expand(Board& board, int split_depth, std::map<std::string, Unit>& units) {
+    if (split_depth == 0) {
+        std::string fen = board.fen();
+        Unit& unit = units[position_key(fen)];
+        if (unit.multiplicity++ == 0)
+            unit.fen = fen;
+        return;
+    }
+
+    MoveList moves;
+    MoveGen::generate_legal_moves(board, moves);
+
+    for (const Move& move : moves) {
+        StateInfo st;
+        board.make_move(move, st);
+        expand(board, split_depth - 1, units);
+        board.unmake_move(move, st);
+    }
+}
+
+std::vector<fs::path> list(const fs::path& dir, const std::string& extension = "") {
+    std::vector<fs::path> paths;
+    std::error_code ec;
+    for (const fs::directory_entry& e : fs::directory_iterator(dir, ec))
+        if (extension.empty() || e.path().extension() == extension)
+            paths.push_back(e.path());
+    return paths;
+}
+
+bool process_alive(pid_t pid) {
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+// Put claims of workers that died back in the queue. Only workers on this
+// machine can be checked; claims of live or remote workers are left alone.
+void requeue_stale(const fs::path& spool) {
+    for (const fs::path& claim : list(spool / "claimed")) {
+        std::string id = claim.stem().string();
+        pid_t pid = std::atoi(claim.extension().string().c_str() + 1);
+        std::error_code ec;
+
+        if (fs::exists(spool / "results" / (id + ".result")))
+            fs::remove(claim, ec);
+        else if (!process_alive(pid))
+            fs::rename(claim, spool / "units" / (id + ".unit"), ec);
+    }
+}
+
+// Start `workers` copies of this executable in worker mode and wait for them
+void run_workers(const fs::path& spool, int workers, std::ostream& out) {
+    out << std::flush;
+    std::cout << std::flush;
+
+    // The resolved path, so the workers show up under their own name
+    std::error_code ec;
+    fs::path exe = fs::read_symlink("/proc/self/exe", ec);
+    if (ec)
+        exe = "/proc/self/exe";
+
+    std::vector<pid_t> children;
+    for (int i = 0; i < workers; i++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            execl(exe.c_str(), "chess-engine", "dperft-worker", spool.c_str(), nullptr);
+            _exit(127);
+        }
+        if (pid > 0)
+            children.push_back(pid);
+    }
+
+    for (pid_t pid : children) {
+        int status;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            out << "Worker " << pid << " failed\n";
+    }
+}
+
+} // namespace
+
+bool coordinate(const std::string& spool_dir, const Board& root, int depth, int split_depth,
+                int workers, uint64_t& nodes, std::ostream& out) {
+    fs::path spool(spool_dir);
+    std::error_code ec;
+    for (const char* dir : {"units", "claimed", "results"})
+        fs::create_directories(spool / dir, ec);
+    if (ec) {
+        out << "Cannot create " << spool_dir << "\n";
+        return false;
+    }
+
+    // Leave at least one ply below the split so every unit does real work
+    if (depth < 1)
+        return false;
+    split_depth = std::clamp(split_depth, 0, depth - 1);
+
+    Job job;
+    Board board = root;
+    if (read_job(spool / "job", job)) {
+        if (job.fen != root.fen() || job.depth != depth || job.split_depth != split_depth) {
+            out << spool_dir << " holds a different job: " << job.fen << " depth " << job.depth
+                << " split " << job.split_depth << "\n";
+            return false;
+        }
+        out << "Resuming " << job.units << " units\n";
+    } else {
+        // Leftovers of an expansion that never finished
+        for (const char* dir : {"units", "claimed", "results"})
+            for (const fs::path& p : list(spool / dir))
+                fs::remove(p, ec);
+
+        std::map<std::string, Unit> units;
+        expand(board, split_depth, units);
+
+        uint64_t leaves = 0;
+        size_t id = 0;
+        for (const auto& [key, unit] : units) {
+            char name[32];
+            std::snprintf(name, sizeof name, "%07zu.unit", id++);
+            std::string text = unit.fen + "\n" + std::to_string(depth - split_depth) + " "
+                             + std::to_string(unit.multiplicity) + "\n";
+            if (!write_atomic(spool / "units" / name, text)) {
+                out << "Cannot write units to " << spool_dir << "\n";
+                return false;
+            }
+            leaves += unit.multiplicity;
+        }
+
+        job = {root.fen(), depth, split_depth, units.size()};
+        std::string text = "fen " + job.fen + "\ndepth " + std::to_string(depth) + "\nsplit "
+                         + std::to_string(split_depth) + "\nunits " + std::to_string(job.units) + "\n";
+        if (!write_atomic(spool / "job", text)) {
+            out << "Cannot write " << (spool / "job").string() << "\n";
+            return false;
+        }
+        out << "Wrote " << job.units << " units for " << leaves << " positions at split depth "
+            << split_depth << "\n";
+    }
+
+    // Rounds of local workers, until a round leaves nothing to requeue
+    size_t done = list(spool / "results", ".result").size();
+    while (workers > 0 && done < job.units) {
+        requeue_stale(spool);
+        if (list(spool / "units", ".unit").empty())
+            break;
+
+        run_workers(spool, workers, out);
+
+        size_t now = list(spool / "results", ".result").size();
+        if (now == done)
+            break;
+        done = now;
+    }
+
+    nodes = 0;
+    done = 0;
+    for (const fs::path& p : list(spool / "results", ".result")) {
+        std::ifstream f(p);
+        uint64_t subtree = 0, multiplicity = 0;
+        if (f >> subtree >> multiplicity) {
+            nodes += subtree * multiplicity;
+            done++;
+        }
+    }
+
+    if (done < job.units) {
+        out << done << " of " << job.units << " units done\n";
+        return false;
+    }
+    return true;
+}
+
+size_t work(const std::string& spool_dir, size_t hash_mb, std::ostream& out) {
+    fs::path spool(spool_dir);
+    std::string pid = std::to_string(getpid());
+    Perft::PerftTable table(hash_mb);
+    size_t solved = 0;
+
+    for (bool claimed_any = true; claimed_any; ) {
+        claimed_any = false;
+
+        for (const fs::path& unit : list(spool / "units", ".unit")) {
+            // The rename is the claim: exactly one worker wins it
+            std::string id = unit.stem().string();
+            fs::path claim = spool / "claimed" / (id + "." + pid);
+            std::error_code ec;
+            fs::rename(unit, claim, ec);
+            if (ec)
+                continue;
+            claimed_any = true;
+
+            std::ifstream f(claim);
+            std::string fen;
+            int depth = 0;
+            uint64_t multiplicity = 0;
+            Board board;
+            if (!std::getline(f, fen) || !(f >> depth >> multiplicity) || !board.set_fen(fen)) {
+                out << "Bad unit " << id << "\n";
+                continue;
+            }
+
+            uint64_t nodes = Perft::perft(board, depth, table);
+            if (!write_atomic(spool / "results" / (id + ".result"),
+                              std::to_string(nodes) + " " + std::to_string(multiplicity) + "\n")) {
+                out << "Cannot write result " << id << "\n";
+                continue;
+            }
+            fs::remove(claim, ec);
+            solved++;
+        }
+    }
+
+    return solved;
+}
+
+}
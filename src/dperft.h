@@ -0,0 +1,36 @@
+#pragma once
+
+#include "board.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Perft spread over independent worker processes that share a spool
+// directory, for runs too long for one process or one machine:
+//
+//   <spool>/job                   root FEN, depth, split depth and unit count,
+//                                 written once every unit is in place
+//   <spool>/units/<id>.unit       pending work: FEN, remaining depth, multiplicity
+//   <spool>/claimed/<id>.<pid>    a unit a worker is running
+//   <spool>/results/<id>.result   subtree node count and multiplicity
+//
+// Every state change is a rename within the spool, so a crashed worker or
+// coordinator leaves no half-written file behind, and running the
+// coordinator again with the same arguments resumes the job.
+namespace DistPerft {
+    // Expand the tree split_depth plies below root and write one unit per
+    // distinct position, weighted by how many move orders reach it. Then run
+    // `workers` worker processes of this executable until every unit has a
+    // result, and sum the results into `nodes`. With 0 workers only the
+    // spool is prepared (or checked), for workers started elsewhere.
+    // Returns false on error, or if results are still missing.
+    bool coordinate(const std::string& spool, const Board& root, int depth, int split_depth,
+                    int workers, uint64_t& nodes, std::ostream& out = std::cout);
+
+    // Claim units and run them until none are left. Each worker uses a
+    // private perft hash table of hash_mb megabytes. Returns the number of
+    // units solved.
+    size_t work(const std::string& spool, size_t hash_mb, std::ostream& out = std::cout);
+}
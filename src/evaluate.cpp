@@ -0,0 +1,42 @@
+#include "evaluate.h"
+#include "bitbase.h"
+#include "nnue.h"
+
+#include <algorithm>
+
+namespace Eval {
+
+// Exact result of king and pawn vs king: a draw, or a win that scores
+// better the further the pawn has come
+static int evaluate_kpk(const Board& board) {
+    Color strong = board.pieces(WHITE, PAWN) ? WHITE : BLACK;
+    if (!Bitbases::probe_kpk(board, strong))
+        return 0;
+
+    int pawn_rank = Bitboards::lsb(board.pieces(strong, PAWN)) / 8;
+    int score = KNOWN_WIN + 10 * (strong == WHITE ? pawn_rank : 7 - pawn_rank);
+    return board.side_to_move == strong ? score : -score;
+}
+
+int evaluate(const Board& board, Pawns::Table& pawns) {
+    // No pieces besides the kings and a single pawn
+    if (board.phase == 0 && Bitboards::popcount(board.occupied()) == 3 && board.by_type[PAWN])
+        return evaluate_kpk(board);
+
+    // A board only carries an accumulator while a network is loaded
+    if (board.accumulator)
+        return NNUE::evaluate(board);
+
+    const Pawns::Entry& pe = pawns.probe(board);
+
+    int mg = board.psq_mg + pe.mg;
+    int eg = board.psq_eg + pe.eg;
+
+    // Early promotions can push the phase past its starting value
+    int phase = std::min(board.phase, PSQT::MAX_PHASE);
+    int score = (mg * phase + eg * (PSQT::MAX_PHASE - phase)) / PSQT::MAX_PHASE;
+
+    return board.side_to_move == WHITE ? score : -score;
+}
+
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "board.h"
+#include "pawns.h"
+
+namespace Eval {
+    // Score of an endgame the bitbases call won, plus a little for progress;
+    // far below the mate scores
+    constexpr int KNOWN_WIN = 10000;
+
+    // Static evaluation in centipawns from the side to move's point of view.
+    // Material and piece-square terms come from the sums Board keeps up to
+    // date, pawn structure from the pawn hash table, and the middlegame and
+    // endgame scores are blended by game phase. King and pawn vs king is
+    // looked up in the bitbase instead. Boards with an NNUE accumulator
+    // attached are scored by the network.
+    int evaluate(const Board& board, Pawns::Table& pawns);
+}
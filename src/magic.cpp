@@ -0,0 +1,112 @@
+#include "magic.h"
+#include "bitboard.h"
+#include "util.h"
+
+namespace MoveGen {
+
+Magic bishop_magics[64];
+Magic rook_magics[64];
+
+namespace {
+
+// Shared attack tables, indexed through the per-square Magic entries.
+// Sizes are the sum over all squares of 2^(relevant bits).
+Bitboard bishop_table[0x1480];
+Bitboard rook_table[0x19000];
+
+const int bishop_dirs[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+const int rook_dirs[4][2]   = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+// Walk every ray from square, stopping on (and including) the first blocker.
+// Only used while building the tables, so speed does not matter here.
+Bitboard sliding_attacks(const int dirs[4][2], int square, Bitboard occupied) {
+    Bitboard attacks = EMPTY_BITBOARD;
+
+    for (int d = 0; d < 4; d++) {
+        int rank = square / 8 + dirs[d][0];
+        int file = square % 8 + dirs[d][1];
+
+        while (rank >= 0 && rank <= 7 && file >= 0 && file <= 7) {
+            int to = rank * 8 + file;
+            Bitboards::set_bit(attacks, to);
+            if (Bitboards::get_bit(occupied, to))
+                break;
+            rank += dirs[d][0];
+            file += dirs[d][1];
+        }
+    }
+
+    return attacks;
+}
+
+void init_magics(const int dirs[4][2], Magic magics[64], Bitboard* table) {
+#ifndef USE_PEXT
+    static Bitboard occupancy[4096], reference[4096];
+    static int epoch[4096];
+    static int current_epoch = 0;
+    // A fixed seed keeps the magics (and the startup time) identical between runs
+    PRNG rng{728ULL};
+#endif
+    Bitboard* next_slice = table;
+
+    for (int sq = 0; sq < 64; sq++) {
+        Magic& m = magics[sq];
+
+        // Board edges never block a ray, unless the slider itself is on them
+        Bitboard rank_edges = 0xFF000000000000FFULL & ~(0xFFULL << (8 * (sq / 8)));
+        Bitboard file_edges = 0x8181818181818181ULL & ~(0x0101010101010101ULL << (sq % 8));
+        Bitboard edges = rank_edges | file_edges;
+
+        m.mask = sliding_attacks(dirs, sq, EMPTY_BITBOARD) & ~edges;
+        m.shift = 64 - Bitboards::popcount(m.mask);
+        m.attacks = next_slice;
+
+        // Enumerate every subset of the mask (Carry-Rippler trick) and record
+        // the true attack set for each of them
+        int size = 0;
+        Bitboard subset = EMPTY_BITBOARD;
+        do {
+#ifdef USE_PEXT
+            m.attacks[m.index(subset)] = sliding_attacks(dirs, sq, subset);
+#else
+            occupancy[size] = subset;
+            reference[size] = sliding_attacks(dirs, sq, subset);
+#endif
+            size++;
+            subset = (subset - m.mask) & m.mask;
+        } while (subset);
+
+        next_slice += size;
+
+#ifndef USE_PEXT
+        // Try random candidates until one maps every subset to a slot that is
+        // either unused or already holds the same attack set
+        for (int i = 0; i < size; ) {
+            do {
+                m.magic = rng.sparse_rand();
+            } while (Bitboards::popcount((m.mask * m.magic) >> 56) < 6);
+
+            current_epoch++;
+            for (i = 0; i < size; i++) {
+                unsigned idx = m.index(occupancy[i]);
+
+                if (epoch[idx] < current_epoch) {
+                    epoch[idx] = current_epoch;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+#endif
+    }
+}
+
+} // namespace
+
+void init_slider_attacks() {
+    init_magics(bishop_dirs, bishop_magics, bishop_table);
+    init_magics(rook_dirs, rook_magics, rook_table);
+}
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "types.h"
+
+#ifdef USE_PEXT
+#include <immintrin.h>
+#endif
+
+namespace MoveGen {
+    // Sliding attack lookup for one square. The relevant occupancy (the
+    // blockers that can actually stop a ray, board edges excluded) is mapped
+    // to a dense index into this square's slice of the shared attack table,
+    // either by a magic multiply-shift or, when built with USE_PEXT, by the
+    // BMI2 parallel bit extract instruction.
+    struct Magic {
+        Bitboard mask;      // Relevant occupancy squares
+        Bitboard magic;     // Magic multiplier (unused with PEXT)
+        Bitboard* attacks;  // Start of this square's attack table slice
+        int shift;          // 64 minus the number of relevant bits
+
+        unsigned index(Bitboard occupied) const {
+#ifdef USE_PEXT
+            return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+            return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+        }
+    };
+
+    extern Magic bishop_magics[64];
+    extern Magic rook_magics[64];
+
+    // To initialize bishop and rook attacks lookup tables
+    void init_slider_attacks();
+
+    inline Bitboard bishop_attacks(int square, Bitboard occupied) {
+        const Magic& m = bishop_magics[square];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard rook_attacks(int square, Bitboard occupied) {
+        const Magic& m = rook_magics[square];
+        return m.attacks[m.index(occupied)];
+    }
+
+    inline Bitboard queen_attacks(int square, Bitboard occupied) {
+        return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+    }
+}
@@ -1,24 +1,254 @@
 // main.cpp
 #include "types.h"
 #include "util.h"
+#include "bench.h"
 #include "board.h"
 #include "movegen.h"
+#include "bitbase.h"
 #include "bitboard.h"
+#include "book.h"
+#include "dperft.h"
+#include "nnue.h"
+#include "packed.h"
+#include "perft.h"
+#include "search.h"
+#include "selftest.h"
+#include "stats.h"
+#include "uci.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main() {
-    MoveGen::init_knight_attacks();
-    MoveGen::init_king_attacks();
-
+static int run(int argc, char* argv[]) {
     Board board;
     board.init_startpos();
 
-    for (int depth = 1; depth <= 4; depth++) {
-        uint64_t nodes = MoveGen::perft(board, depth);
+    std::string command = argc >= 2 ? argv[1] : "";
+
+    // chess-engine divide <depth> [fen]: per-root-move perft counts
+    if (command == "divide" && argc >= 3) {
+        if (argc >= 4 && !board.set_fen(argv[3])) {
+            std::cerr << "Invalid FEN: " << argv[3] << "\n";
+            return 1;
+        }
+        Perft::divide(board, std::atoi(argv[2]));
+        return 0;
+    }
 
-        std::cout << "Depth: " << depth << " Total nodes: " << nodes << "\n";
+    // chess-engine perft <depth> [threads] [fen]: node count, work-stealing
+    // over `threads` threads (default: all cores)
+    if (command == "perft" && argc >= 3) {
+        int depth = std::atoi(argv[2]);
+        int threads = argc >= 4 ? std::atoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+        if (argc >= 5 && !board.set_fen(argv[4])) {
+            std::cerr << "Invalid FEN: " << argv[4] << "\n";
+            return 1;
+        }
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = Perft::perft_parallel(board, depth, std::max(threads, 1));
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Nodes: " << nodes << "\nTime: " << seconds << "s\nNPS: "
+                  << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << "\n";
+        return 0;
     }
 
+    // chess-engine perft-suite <file.epd> [max-depth] [cache-file] [cache-mb]:
+    // correctness and speed check, optionally through a persistent cache
+    if (command == "perft-suite" && argc >= 3) {
+        int max_depth = argc >= 4 ? std::atoi(argv[3]) : 64;
+        if (argc < 5)
+            return Perft::run_suite(argv[2], max_depth) ? 0 : 1;
+
+        size_t cache_mb = argc >= 6 ? std::atoi(argv[5]) : 256;
+        Perft::PerftTable cache(1);
+        if (!cache.open(argv[4], cache_mb)) {
+            std::cerr << "Cannot open cache " << argv[4] << "\n";
+            return 1;
+        }
+        return Perft::run_suite(argv[2], max_depth, std::cout, &cache) ? 0 : 1;
+    }
+
+    // chess-engine search <depth> [threads] [fen]: fixed-depth search with a 16 MB hash
+    if (command == "search" && argc >= 3) {
+        int threads = argc >= 4 ? std::atoi(argv[3]) : 1;
+        if (argc >= 5 && !board.set_fen(argv[4])) {
+            std::cerr << "Invalid FEN: " << argv[4] << "\n";
+            return 1;
+        }
+        Search::TranspositionTable tt(16);
+        Search::Limits limits;
+        limits.depth = std::atoi(argv[2]);
+        Search::Result result = Search::search(board, limits, tt, threads);
+        std::cout << "bestmove " << move_to_string(result.best_move) << "\n";
+        return 0;
+    }
+
+    // chess-engine ttd <depth> [threads...]: time-to-depth scaling over the
+    // bench positions, e.g. "ttd 12 1 2 4 8"
+    if (command == "ttd" && argc >= 3) {
+        std::vector<int> thread_counts;
+        for (int i = 3; i < argc; i++)
+            thread_counts.push_back(std::atoi(argv[i]));
+        if (thread_counts.empty())
+            thread_counts = {1, 2, 4, 8, 16, 32};
+        Search::time_to_depth(Search::bench_positions, std::atoi(argv[2]), thread_counts, 64);
+        return 0;
+    }
+
+    // chess-engine pack <in.epd> <out.bin>: convert FEN/EPD lines to packed records
+    if (command == "pack" && argc >= 4) {
+        std::ifstream in(argv[2]);
+        Packed::Writer writer;
+        if (!in || !writer.open(argv[3])) {
+            std::cerr << "Cannot open " << (in ? argv[3] : argv[2]) << "\n";
+            return 1;
+        }
+        size_t written = 0, skipped = 0;
+        std::string line;
+        while (std::getline(in, line)) {
+            Board b;
+            if (b.set_fen(line.substr(0, line.find(';'))) && writer.write(b))
+                written++;
+            else
+                skipped++;
+        }
+        if (!writer.close()) {
+            std::cerr << "Write error on " << argv[3] << "\n";
+            return 1;
+        }
+        std::cout << "Packed " << written << " positions, skipped " << skipped << " lines\n";
+        return 0;
+    }
+
+    // chess-engine perft-packed <file.bin> <depth> [threads]: perft summed
+    // over every record of a packed file
+    if (command == "perft-packed" && argc >= 4) {
+        Packed::Reader reader;
+        if (!reader.open(argv[2])) {
+            std::cerr << "Cannot map " << argv[2] << "\n";
+            return 1;
+        }
+        int depth = std::atoi(argv[3]);
+        int threads = argc >= 5 ? std::atoi(argv[4]) : 1;
+
+        std::vector<Perft::Counter> counters(std::max(threads, 1));
+        auto start = std::chrono::steady_clock::now();
+        Packed::for_each_parallel(reader, threads, [&](const Packed::PackedPosition& record, size_t, int worker) {
+            Board b;
+            if (Packed::unpack(record, b))
+                counters[worker].nodes += MoveGen::perft(b, depth);
+        });
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        uint64_t nodes = 0;
+        for (const Perft::Counter& c : counters)
+            nodes += c.nodes;
+        std::cout << "Positions: " << reader.size() << "  Nodes: " << nodes << "  Time: " << seconds
+                  << "s  NPS: " << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << "\n";
+        return 0;
+    }
+
+    // chess-engine dperft <depth> <split-depth> <spool-dir> <workers> [fen]:
+    // perft run by worker processes sharing a spool directory; run it again
+    // with the same arguments to resume
+    if (command == "dperft" && argc >= 6) {
+        if (argc >= 7 && !board.set_fen(argv[6])) {
+            std::cerr << "Invalid FEN: " << argv[6] << "\n";
+            return 1;
+        }
+        uint64_t nodes = 0;
+        auto start = std::chrono::steady_clock::now();
+        if (!DistPerft::coordinate(argv[4], board, std::atoi(argv[2]), std::atoi(argv[3]), std::atoi(argv[5]), nodes))
+            return 1;
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Nodes: " << nodes << "  Time: " << seconds << "s\n";
+        return 0;
+    }
+
+    // chess-engine dperft-worker <spool-dir> [hash-mb]: solve units of a
+    // dperft spool until none are left
+    if (command == "dperft-worker" && argc >= 3) {
+        size_t hash_mb = argc >= 4 ? std::atoi(argv[3]) : 64;
+        DistPerft::work(argv[2], hash_mb);
+        return 0;
+    }
+
+    // chess-engine book <book.bin> [fen]: Polyglot book moves of a position
+    if (command == "book" && argc >= 3) {
+        Book::PolyglotBook book;
+        if (!book.open(argv[2])) {
+            std::cerr << "Cannot map " << argv[2] << "\n";
+            return 1;
+        }
+        if (argc >= 4 && !board.set_fen(argv[3])) {
+            std::cerr << "Invalid FEN: " << argv[3] << "\n";
+            return 1;
+        }
+        std::cout << "Key: " << std::hex << Book::key(board) << std::dec << "\n";
+        for (const Book::BookMove& m : book.probe(board))
+            std::cout << move_to_string(m.move) << " " << m.weight << "\n";
+        return 0;
+    }
+
+    // chess-engine selftest: known-answer checks beyond perft
+    if (command == "selftest")
+        return SelfTest::run() ? 0 : 1;
+
+    // chess-engine bench [samples] [out.json]: move generation microbenchmarks
+    if (command == "bench") {
+        int samples = argc >= 3 ? std::atoi(argv[2]) : 10;
+        std::vector<Bench::Result> results = Bench::run(samples);
+        if (argc >= 4 && !Bench::write_json(results, argv[3])) {
+            std::cerr << "Cannot write " << argv[3] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // chess-engine nnue-bench [samples] [net.nnue]: network evaluation with
+    // incremental accumulators vs full recomputation, on random weights if
+    // no network is given
+    if (command == "nnue-bench") {
+        int samples = argc >= 3 ? std::atoi(argv[2]) : 10;
+        if (argc < 4) {
+            NNUE::randomize(1);
+        } else if (!NNUE::load(argv[3])) {
+            std::cerr << "Cannot load network " << argv[3] << "\n";
+            return 1;
+        }
+        std::vector<Bench::Result> results;
+        return Bench::run_nnue(samples, results) ? 0 : 1;
+    }
+
+    // chess-engine nnue-random <out.nnue> [seed]: write a network of random
+    // weights, to exercise the EvalFile option without a trained network
+    if (command == "nnue-random" && argc >= 3) {
+        NNUE::randomize(argc >= 4 ? std::strtoull(argv[3], nullptr, 10) : 1);
+        if (!NNUE::save(argv[2])) {
+            std::cerr << "Cannot write " << argv[2] << "\n";
+            return 1;
+        }
+        return 0;
+    }
+
+    // No command: speak UCI on stdin/stdout
+    UCI::loop();
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    MoveGen::init_slider_attacks();
+    Bitbases::init();
+
+    int status = run(argc, argv);
+
+    // Instrumented builds report what the whole run did
+    Stats::print();
+    return status;
+}
@@ -1,507 +1,736 @@
 #include "movegen.h"
+#include "stats.h"
 
 #include <iostream>
 
 namespace MoveGen {
 
-// Global lookup table for knight moves
-Bitboard knight_attacks[64];
-
-// Global lookup table for king moves
-Bitboard king_attacks[64];
-
-uint64_t perft(const Board& board, int depth) {
+uint64_t perft(Board& board, int depth) {
     if (depth == 0)
         return 1ULL;
 
+    // Bulk counting: the frontier nodes are the legal moves themselves
+    if (depth == 1)
+        return count_legal_moves(board);
+
     uint64_t nodes = 0ULL;
-    auto moves = generate_legal_moves(board);
+    MoveList moves;
+    generate_legal_moves(board, moves);
 
+    // Every generated move is legal, so no further king safety test is needed
     for (const Move &move : moves) {
-        Board copy_board = board;
+        StateInfo st;
+        board.make_move(move, st);
+        nodes += perft(board, depth - 1);
+        board.unmake_move(move, st);
+    }
 
-        // Clearly make move
-        if (!copy_board.make_move(move))
-            continue; // skip if invalid
+    return nodes;
+}
 
-        Color us = board.side_to_move; // side before move
-        Color them = (us == WHITE) ? BLACK : WHITE; // side after move
+#ifdef USE_STATS
+// Moves a pseudo-legal generator would emit: every target not holding one of
+// our pieces, with pins, checks and king safety ignored. Only computed for
+// the instrumentation's pseudo-legal vs legal comparison.
+template<Color Us>
+static int pseudo_legal_count(const Board &board) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr Bitboard third_rank = (Us == WHITE) ? 0x0000000000FF0000ULL : 0x0000FF0000000000ULL;
+    constexpr Bitboard promotion_rank = (Us == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+    constexpr int rank_shift = (Us == WHITE) ? 0 : 56;
+
+    Bitboard own_pieces = board.occupied(Us);
+    Bitboard enemy_pieces = board.occupied(Them);
+    Bitboard occupied = board.occupied();
+    Bitboard pawns = board.pieces(Us, PAWN);
+
+    // Pushes, double pushes and captures, four moves for each promotion
+    Bitboard single_pushes = pawn_push<Us>(pawns) & ~occupied;
+    int count = Bitboards::popcount(pawn_push<Us>(single_pushes & third_rank) & ~occupied);
+    for (Bitboard targets : {single_pushes, pawn_attacks_left<Us>(pawns) & enemy_pieces, pawn_attacks_right<Us>(pawns) & enemy_pieces})
+        count += Bitboards::popcount(targets & ~promotion_rank) + 4 * Bitboards::popcount(targets & promotion_rank);
+    if (board.en_passant_square != -1)
+        count += Bitboards::popcount(pawn_attacks[Them][board.en_passant_square] & pawns);
 
-        // Get king's position after move
-        Bitboard king_bb = copy_board.pieces[us][KING];
-        int king_square = Bitboards::lsb(king_bb);
+    Bitboard knights = board.pieces(Us, KNIGHT);
+    while (knights) {
+        int from = Bitboards::lsb(knights);
+        Bitboards::clear_bit(knights, from);
+        count += Bitboards::popcount(knight_attacks[from] & ~own_pieces);
+    }
 
-        if (is_square_attacked(copy_board, king_square, them))
-            continue; // skip if move leaves king in check
+    Bitboard diagonal = board.pieces(Us, BISHOP, QUEEN);
+    while (diagonal) {
+        int from = Bitboards::lsb(diagonal);
+        Bitboards::clear_bit(diagonal, from);
+        count += Bitboards::popcount(bishop_attacks(from, occupied) & ~own_pieces);
+    }
 
-        nodes += perft(copy_board, depth - 1);
+    Bitboard straight = board.pieces(Us, ROOK, QUEEN);
+    while (straight) {
+        int from = Bitboards::lsb(straight);
+        Bitboards::clear_bit(straight, from);
+        count += Bitboards::popcount(rook_attacks(from, occupied) & ~own_pieces);
     }
 
-    return nodes;
+    count += Bitboards::popcount(king_attacks[Bitboards::lsb(board.pieces(Us, KING))] & ~own_pieces);
+
+    // Castling with the rights and an empty path, attacked squares or not
+    if ((board.castling_rights & (Us == WHITE ? 1 : 4)) && !(occupied & (0x60ULL << rank_shift)))
+        count++;
+    if ((board.castling_rights & (Us == WHITE ? 2 : 8)) && !(occupied & (0x0EULL << rank_shift)))
+        count++;
+
+    return count;
 }
+#endif
 
-std::vector<Move> generate_legal_moves(const Board &board) {
-    std::vector<Move> pseudo_legal_moves;
+template<Color Us, GenType Type>
+void generate_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_TIME(GENERATE);
 
-    generate_pawn_moves(board, pseudo_legal_moves);
-    generate_knight_moves(board, pseudo_legal_moves);
-    generate_bishop_moves(board, pseudo_legal_moves);
-    generate_rook_moves(board, pseudo_legal_moves);
-    generate_queen_moves(board, pseudo_legal_moves);
-    generate_king_moves(board, pseudo_legal_moves);
-    generate_castling_moves(board, pseudo_legal_moves);
+    generate_king_moves<Us, Type>(board, info, moves);
 
-    std::vector<Move> legal_moves;
+    // In double check only the king can move
+    if (Bitboards::popcount(info.checkers) > 1)
+        return;
 
-    for (const Move& move : pseudo_legal_moves) {
-        Board board_copy = board;
-        board_copy.make_move(move);
+    generate_pawn_moves<Us, Type>(board, info, moves);
+    generate_knight_moves<Us, Type>(board, info, moves);
+    generate_bishop_moves<Us, Type>(board, info, moves);
+    generate_rook_moves<Us, Type>(board, info, moves);
+    generate_queen_moves<Us, Type>(board, info, moves);
 
-        // Get king's square after move
-        Bitboard king_bb = board_copy.pieces[board.side_to_move][KING];
-        int king_square = Bitboards::lsb(king_bb);
+    // Castling is a quiet move, and never legal while in check
+    if constexpr (Type == QUIETS || Type == LEGAL)
+        generate_castling_moves<Us>(board, info, moves);
+}
 
-        if (!is_square_attacked(board_copy, king_square, board_copy.side_to_move)) {
-            legal_moves.push_back(move);
-        }
+template<Color Us>
+void generate_legal_moves(const Board &board, MoveList &moves) {
+    [[maybe_unused]] int first = moves.size();
+    generate_moves<Us, LEGAL>(board, compute_check_info<Us>(board), moves);
+
+    STATS_ADD(LEGAL_MOVES, moves.size() - first);
+    STATS_ADD(PSEUDO_LEGAL_MOVES, pseudo_legal_count<Us>(board));
+}
+
+template<Color Us>
+bool is_legal(const Board &board, const CheckInfo &info, Move move) {
+    int from = move.from();
+    if (!Bitboards::get_bit(board.occupied(Us), from))
+        return false;
+
+    // Generate the legal moves of the moving piece type only and look for the move
+    MoveList moves;
+    switch (board.board[from]) {
+        case PAWN:   generate_pawn_moves<Us>(board, info, moves); break;
+        case KNIGHT: generate_knight_moves<Us>(board, info, moves); break;
+        case BISHOP: generate_bishop_moves<Us>(board, info, moves); break;
+        case ROOK:   generate_rook_moves<Us>(board, info, moves); break;
+        case QUEEN:  generate_queen_moves<Us>(board, info, moves); break;
+        case KING:
+            generate_king_moves<Us>(board, info, moves);
+            generate_castling_moves<Us>(board, info, moves);
+            break;
+        default: return false;
     }
 
-    return legal_moves;
+    // Only the king may move in double check
+    if (board.board[from] != KING && Bitboards::popcount(info.checkers) > 1)
+        return false;
+
+    for (const Move& m : moves)
+        if (m == move)
+            return true;
+    return false;
+}
+
+// Number of moves for the given pawns, with destinations restricted to targets
+template<Color Us>
+static int count_pawn_moves(Bitboard pawns, Bitboard empty, Bitboard enemy_pieces, Bitboard targets) {
+    constexpr Bitboard promotion_rank = (Us == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+    constexpr Bitboard third_rank = (Us == WHITE) ? 0x0000000000FF0000ULL : 0x0000FF0000000000ULL;
+
+    Bitboard single_pushes = pawn_push<Us>(pawns) & empty;
+    Bitboard double_pushes = pawn_push<Us>(single_pushes & third_rank) & empty & targets;
+    Bitboard captures_left  = pawn_attacks_left<Us>(pawns) & enemy_pieces & targets;
+    Bitboard captures_right = pawn_attacks_right<Us>(pawns) & enemy_pieces & targets;
+    single_pushes &= targets;
+
+    // Each promotion counts four times (queen, rook, bishop, knight)
+    return Bitboards::popcount(single_pushes & ~promotion_rank)
+         + Bitboards::popcount(captures_left & ~promotion_rank)
+         + Bitboards::popcount(captures_right & ~promotion_rank)
+         + 4 * (Bitboards::popcount(single_pushes & promotion_rank)
+              + Bitboards::popcount(captures_left & promotion_rank)
+              + Bitboards::popcount(captures_right & promotion_rank))
+         + Bitboards::popcount(double_pushes);
+}
+
+template<Color Us>
+int count_legal_moves(const Board &board) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    STATS_TIME(COUNT_MOVES);
+    STATS_ADD(PSEUDO_LEGAL_MOVES, pseudo_legal_count<Us>(board));
+
+    CheckInfo info = compute_check_info<Us>(board);
+    Bitboard own_pieces = board.occupied(Us);
+    Bitboard occupied = board.occupied();
+
+    int count = Bitboards::popcount(king_attacks[info.king_square] & ~own_pieces & ~info.king_danger);
+
+    // In double check only the king can move
+    if (Bitboards::popcount(info.checkers) > 1)
+        return count;
+
+    // Pawns: unpinned ones in bulk, pinned ones along their pin ray
+    Bitboard pawns = board.pieces(Us, PAWN);
+    Bitboard enemy_pieces = board.occupied(Them);
+    count += count_pawn_moves<Us>(pawns & ~info.pinned, ~occupied, enemy_pieces, info.check_mask);
+
+    Bitboard pinned_pawns = pawns & info.pinned;
+    while (pinned_pawns) {
+        int from = Bitboards::lsb(pinned_pawns);
+        Bitboards::clear_bit(pinned_pawns, from);
+        count += count_pawn_moves<Us>(1ULL << from, ~occupied, enemy_pieces, pin_mask(info, from));
+    }
+
+    count += Bitboards::popcount(en_passant_capturers<Us>(board, info));
+
+    // A pinned knight can never move
+    Bitboard knights = board.pieces(Us, KNIGHT) & ~info.pinned;
+    while (knights) {
+        int from = Bitboards::lsb(knights);
+        Bitboards::clear_bit(knights, from);
+        count += Bitboards::popcount(knight_attacks[from] & ~own_pieces & info.check_mask);
+    }
+
+    Bitboard diagonal = board.pieces(Us, BISHOP, QUEEN);
+    while (diagonal) {
+        int from = Bitboards::lsb(diagonal);
+        Bitboards::clear_bit(diagonal, from);
+        count += Bitboards::popcount(bishop_attacks(from, occupied) & ~own_pieces & pin_mask(info, from));
+    }
+
+    Bitboard straight = board.pieces(Us, ROOK, QUEEN);
+    while (straight) {
+        int from = Bitboards::lsb(straight);
+        Bitboards::clear_bit(straight, from);
+        count += Bitboards::popcount(rook_attacks(from, occupied) & ~own_pieces & pin_mask(info, from));
+    }
+
+    count += Bitboards::popcount(castling_targets<Us>(board, info));
+
+    return count;
+}
+
+// Every square attacked by `Attacker`, with sliders seeing through to `occupied`
+template<Color Attacker>
+Bitboard attacked_squares(const Board& board, Bitboard occupied) {
+    Bitboard attacks = pawn_attacks_bb<Attacker>(board.pieces(Attacker, PAWN));
+    attacks |= king_attacks[Bitboards::lsb(board.pieces(Attacker, KING))];
+
+    Bitboard knights = board.pieces(Attacker, KNIGHT);
+    while (knights) {
+        int sq = Bitboards::lsb(knights);
+        attacks |= knight_attacks[sq];
+        Bitboards::clear_bit(knights, sq);
+    }
+
+    Bitboard diagonal = board.pieces(Attacker, BISHOP, QUEEN);
+    while (diagonal) {
+        int sq = Bitboards::lsb(diagonal);
+        attacks |= bishop_attacks(sq, occupied);
+        Bitboards::clear_bit(diagonal, sq);
+    }
+
+    Bitboard straight = board.pieces(Attacker, ROOK, QUEEN);
+    while (straight) {
+        int sq = Bitboards::lsb(straight);
+        attacks |= rook_attacks(sq, occupied);
+        Bitboards::clear_bit(straight, sq);
+    }
+
+    return attacks;
+}
+
+template<Color Us>
+CheckInfo compute_check_info(const Board& board) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    STATS_TIME(CHECK_INFO);
+
+    Bitboard occupied = board.occupied();
+    Bitboard own_pieces = board.occupied(Us);
+
+    CheckInfo info;
+    info.king_square = Bitboards::lsb(board.pieces(Us, KING));
+    Bitboard king_bb = board.pieces(Us, KING);
+
+    Bitboard enemy_diagonal = board.pieces(Them, BISHOP, QUEEN);
+    Bitboard enemy_straight = board.pieces(Them, ROOK, QUEEN);
+
+    // Leaper checkers: a pawn of ours on the king square would attack exactly them
+    info.checkers = (pawn_attacks[Us][info.king_square] & board.pieces(Them, PAWN))
+                  | (knight_attacks[info.king_square] & board.pieces(Them, KNIGHT));
+
+    // Slider checkers and pins: look from the king through empty board for enemy
+    // sliders, then count what stands in between
+    info.pinned = EMPTY_BITBOARD;
+    Bitboard snipers = (bishop_attacks(info.king_square, EMPTY_BITBOARD) & enemy_diagonal)
+                     | (rook_attacks(info.king_square, EMPTY_BITBOARD) & enemy_straight);
+
+    while (snipers) {
+        int sniper = Bitboards::lsb(snipers);
+        Bitboards::clear_bit(snipers, sniper);
+
+        Bitboard blockers = between_bb[info.king_square][sniper] & occupied;
+
+        if (blockers == EMPTY_BITBOARD)
+            Bitboards::set_bit(info.checkers, sniper);
+        else if (Bitboards::popcount(blockers) == 1 && (blockers & own_pieces))
+            info.pinned |= blockers;
+    }
+
+    if (info.checkers == EMPTY_BITBOARD)
+        info.check_mask = FULL_BITBOARD;
+    else if (Bitboards::popcount(info.checkers) == 1)
+        info.check_mask = info.checkers | between_bb[info.king_square][Bitboards::lsb(info.checkers)];
+    else
+        info.check_mask = EMPTY_BITBOARD;
+
+    // The king must not be treated as a blocker, or it could step back along a checking ray
+    info.king_danger = attacked_squares<Them>(board, occupied & ~king_bb);
+
+    return info;
+}
+
+// Add the move from -> to, or the four promotions if `to` is on the last rank
+template<Color Us>
+static inline void add_pawn_moves(MoveList &moves, int from, int to, bool capture) {
+    constexpr Bitboard promotion_rank = (Us == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+
+    if ((1ULL << to) & promotion_rank) {
+        moves.add(Move::promotion_to(from, to, QUEEN, capture));
+        moves.add(Move::promotion_to(from, to, ROOK, capture));
+        moves.add(Move::promotion_to(from, to, BISHOP, capture));
+        moves.add(Move::promotion_to(from, to, KNIGHT, capture));
+    } else {
+        moves.add(Move(from, to, capture ? CAPTURE : QUIET));
+    }
+}
+
+// Add a move from `from` to every square in targets, all with the same flags
+static inline void add_moves(MoveList &moves, int from, Bitboard targets, int flags) {
+    while (targets) {
+        int to = Bitboards::lsb(targets);
+        moves.add(Move(from, to, flags));
+        Bitboards::clear_bit(targets, to);
+    }
 }
 
 // ------------------- PAWN MOVES ----------------------
-void generate_pawn_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Color them = (us == WHITE) ? BLACK : WHITE;
-    Bitboard pawns = board.pieces[us][PAWN];
-    Bitboard enemy_pieces = board.occupied(them);
+template<Color Us, GenType Type>
+void generate_pawn_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_PAWN);
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+    constexpr int forward = (Us == WHITE) ? 8 : -8;
+    constexpr int left = (Us == WHITE) ? 7 : -9;
+    constexpr int right = (Us == WHITE) ? 9 : -7;
+    constexpr Bitboard third_rank = (Us == WHITE) ? 0x0000000000FF0000ULL : 0x0000FF0000000000ULL;
+    constexpr Bitboard promotion_rank = (Us == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+
+    // Promotions belong to the capture stage, plain pushes to the quiet one
+    constexpr Bitboard push_stage = (Type == CAPTURES) ? promotion_rank
+                                  : (Type == QUIETS)   ? ~promotion_rank
+                                                       : FULL_BITBOARD;
+
+    Bitboard pawns = board.pieces(Us, PAWN);
+    Bitboard enemy_pieces = board.occupied(Them);
     Bitboard empty = ~board.occupied();
 
-    int forward = (us == WHITE) ? 8 : -8;
-    Bitboard promotion_rank = (us == WHITE) ? 0xFF00000000000000ULL : 0x00000000000000FFULL;
+    // A pinned pawn may only move along the line through its king
+    auto pin_allows = [&](int from, int to) {
+        return !Bitboards::get_bit(info.pinned, from)
+            || Bitboards::get_bit(line_bb[info.king_square][from], to);
+    };
 
     // Single pawn pushes
-    Bitboard single_pushes = (us == WHITE) ? (pawns << 8) & empty : (pawns >> 8) & empty;
-    Bitboard temp = single_pushes;
+    Bitboard single_pushes = pawn_push<Us>(pawns) & empty;
+    Bitboard temp = single_pushes & info.check_mask & push_stage;
     while (temp) {
         int to = Bitboards::lsb(temp);
         int from = to - forward;
-
-        // Check promotions
-        if ((1ULL << to) & promotion_rank) {
-            moves.push_back({from, to, QUEEN});
-            moves.push_back({from, to, ROOK});
-            moves.push_back({from, to, BISHOP});
-            moves.push_back({from, to, KNIGHT});
-        } else {
-            moves.push_back({from, to, NO_PIECE});
-        }
         Bitboards::clear_bit(temp, to);
+
+        if (pin_allows(from, to))
+            add_pawn_moves<Us>(moves, from, to, false);
     }
 
     // Double pawn pushes (from original rank)
-    Bitboard double_rank = (us == WHITE) ? 0x000000000000FF00ULL : 0x00FF000000000000ULL;
-    Bitboard double_pushes = (us == WHITE) ? ((single_pushes & (double_rank << 8)) << 8) & empty
-                                           : ((single_pushes & (double_rank >> 8)) >> 8) & empty;
-    temp = double_pushes;
-    while (temp) {
-        int to = Bitboards::lsb(temp);
-        int from = to - (forward * 2);
-        moves.push_back({from, to, NO_PIECE});
-        Bitboards::clear_bit(temp, to);
+    if constexpr (Type != CAPTURES) {
+        temp = pawn_push<Us>(single_pushes & third_rank) & empty & info.check_mask;
+        while (temp) {
+            int to = Bitboards::lsb(temp);
+            int from = to - (forward * 2);
+            Bitboards::clear_bit(temp, to);
+
+            if (pin_allows(from, to))
+                moves.add(Move(from, to, DOUBLE_PUSH));
+        }
     }
 
-    // Pawn captures
-    Bitboard captures_left, captures_right;
-    if (us == WHITE) {
-        captures_left  = (pawns << 7) & enemy_pieces & 0x7F7F7F7F7F7F7F7FULL;  // no wrap-around
-        captures_right = (pawns << 9) & enemy_pieces & 0xFEFEFEFEFEFEFEFEULL;
-    } else {
-        captures_left  = (pawns >> 9) & enemy_pieces & 0x7F7F7F7F7F7F7F7FULL;
-        captures_right = (pawns >> 7) & enemy_pieces & 0xFEFEFEFEFEFEFEFEULL;
-    }
+    if constexpr (Type == QUIETS)
+        return;
 
-    // Handle captures clearly (left)
-    temp = captures_left;
+    // Handle captures (left)
+    temp = pawn_attacks_left<Us>(pawns) & enemy_pieces & info.check_mask;
     while (temp) {
         int to = Bitboards::lsb(temp);
-        int from = to - ((us == WHITE) ? 7 : -9);
-
-        if ((1ULL << to) & promotion_rank) {  // capture promotions
-            moves.push_back({from, to, QUEEN});
-            moves.push_back({from, to, ROOK});
-            moves.push_back({from, to, BISHOP});
-            moves.push_back({from, to, KNIGHT});
-        } else {
-            moves.push_back({from, to, NO_PIECE});
-        }
-
+        int from = to - left;
         Bitboards::clear_bit(temp, to);
+
+        if (pin_allows(from, to))
+            add_pawn_moves<Us>(moves, from, to, true);
     }
 
-    // Handle captures clearly (right)
-    temp = captures_right;
+    // Handle captures (right)
+    temp = pawn_attacks_right<Us>(pawns) & enemy_pieces & info.check_mask;
     while (temp) {
         int to = Bitboards::lsb(temp);
-        int from = to - ((us == WHITE) ? 9 : -7);
-
-        if ((1ULL << to) & promotion_rank) {  // capture promotions
-            moves.push_back({from, to, QUEEN});
-            moves.push_back({from, to, ROOK});
-            moves.push_back({from, to, BISHOP});
-            moves.push_back({from, to, KNIGHT});
-        } else {
-            moves.push_back({from, to, NO_PIECE});
-        }
-
+        int from = to - right;
         Bitboards::clear_bit(temp, to);
+
+        if (pin_allows(from, to))
+            add_pawn_moves<Us>(moves, from, to, true);
     }
 
-    // --- Correct En passant logic clearly ---
-    if (board.en_passant_square != -1) {
-        Bitboard pawns = board.pieces[us][PAWN];
-        Bitboard ep_square_bb = (1ULL << board.en_passant_square);
-
-        if (us == WHITE) {
-            // White pawns can capture en passant diagonally from behind (rank 5)
-            if ((ep_square_bb >> 7) & pawns & 0xFEFEFEFEFEFEFEFEULL) {
-                moves.push_back({board.en_passant_square - 7, board.en_passant_square, NO_PIECE});
-            }
-            if ((ep_square_bb >> 9) & pawns & 0x7F7F7F7F7F7F7F7FULL) {
-                moves.push_back({board.en_passant_square - 9, board.en_passant_square, NO_PIECE});
-            }
-        } else {
-            // Black pawns capturing en passant (rank 4)
-            if ((ep_square_bb << 7) & pawns & 0x7F7F7F7F7F7F7F7FULL) {
-                moves.push_back({board.en_passant_square + 7, board.en_passant_square, NO_PIECE});
-            }
-            if ((ep_square_bb << 9) & pawns & 0xFEFEFEFEFEFEFEFEULL) {
-                moves.push_back({board.en_passant_square + 9, board.en_passant_square, NO_PIECE});
-            }
-        }
+    // --- En passant ---
+    Bitboard ep_capturers = en_passant_capturers<Us>(board, info);
+    while (ep_capturers) {
+        int from = Bitboards::lsb(ep_capturers);
+        moves.add(Move(from, board.en_passant_square, EN_PASSANT));
+        Bitboards::clear_bit(ep_capturers, from);
     }
 }
 
-// Precompute knight moves for every square
-void init_knight_attacks() {
-    for (int sq = 0; sq < 64; sq++) {
-        Bitboard attacks = EMPTY_BITBOARD;
-        Bitboard bit = (1ULL << sq);
+template<Color Us>
+Bitboard en_passant_capturers(const Board &board, const CheckInfo &info) {
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+
+    if (board.en_passant_square == -1)
+        return EMPTY_BITBOARD;
+
+    int ep = board.en_passant_square;
+    int captured_square = ep + ((Us == WHITE) ? -8 : 8);
+
+    // Either the double-pushed pawn is the checker, or the capture blocks the check
+    if (!Bitboards::get_bit(info.check_mask, ep) && !Bitboards::get_bit(info.checkers, captured_square))
+        return EMPTY_BITBOARD;
+
+    // Our pawns that attack the en passant square are exactly those an enemy pawn there would attack
+    Bitboard candidates = pawn_attacks[Them][ep] & board.pieces(Us, PAWN);
+    Bitboard enemy_diagonal = board.pieces(Them, BISHOP, QUEEN);
+    Bitboard enemy_straight = board.pieces(Them, ROOK, QUEEN);
+    Bitboard legal = EMPTY_BITBOARD;
 
-        if ((bit << 17) & 0xFEFEFEFEFEFEFEFEULL) attacks |= (bit << 17);
-        if ((bit << 15) & 0x7F7F7F7F7F7F7F7FULL) attacks |= (bit << 15);
-        if ((bit << 10) & 0xFCFCFCFCFCFCFCFCULL) attacks |= (bit << 10);
-        if ((bit << 15) & 0x7F7F7F7F7F7F7F7FULL) attacks |= (bit << 6);
-        if ((bit >> 17) & 0x7F7F7F7F7F7F7F7FULL) attacks |= (bit >> 17);
-        if ((bit >> 15) & 0xFEFEFEFEFEFEFEFEULL) attacks |= (bit >> 15);
-        if ((bit >> 10) & 0x3F3F3F3F3F3F3F3FULL) attacks |= (bit >> 10);
-        if ((bit >> 15) & 0xFCFCFCFCFCFCFCFCULL) attacks |= (bit >> 6);
+    while (candidates) {
+        int from = Bitboards::lsb(candidates);
+        Bitboards::clear_bit(candidates, from);
 
-        knight_attacks[sq] = attacks;
+        // Two pawns leave the board at once, which can expose the king along the
+        // rank (or a diagonal), so test the resulting occupancy directly
+        Bitboard occupied = (board.occupied() ^ (1ULL << from) ^ (1ULL << captured_square)) | (1ULL << ep);
+        if (bishop_attacks(info.king_square, occupied) & enemy_diagonal)
+            continue;
+        if (rook_attacks(info.king_square, occupied) & enemy_straight)
+            continue;
+
+        Bitboards::set_bit(legal, from);
     }
+
+    return legal;
 }
 
 // ------------------- KNIGHT MOVES ----------------------
-void generate_knight_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Bitboard knights = board.pieces[us][KNIGHT];
-    Bitboard own_pieces = board.occupied(us);
+template<Color Us, GenType Type>
+void generate_knight_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_KNIGHT);
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+
+    Bitboard knights = board.pieces(Us, KNIGHT) & ~info.pinned;  // a pinned knight can never move
+    Bitboard enemy_pieces = board.occupied(Them);
+    Bitboard empty = ~board.occupied();
 
     while (knights) {
         int from = Bitboards::lsb(knights);
         Bitboards::clear_bit(knights, from);
 
-        Bitboard attacks = knight_attacks[from] & ~own_pieces;
-
-        while (attacks) {
-            int to = Bitboards::lsb(attacks);
-            moves.push_back({from, to, NO_PIECE});
-            Bitboards::clear_bit(attacks, to);
-        }
+        Bitboard attacks = knight_attacks[from] & info.check_mask;
+        if constexpr (Type != QUIETS)
+            add_moves(moves, from, attacks & enemy_pieces, CAPTURE);
+        if constexpr (Type != CAPTURES)
+            add_moves(moves, from, attacks & empty, QUIET);
     }
 }
 
 // ------------------- BISHOP MOVES ----------------------
-void generate_bishop_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Bitboard bishops = board.pieces[us][BISHOP];
-    Bitboard own_pieces = board.occupied(us);
-    Bitboard occupied = board.occupied();
+template<Color Us, GenType Type>
+void generate_bishop_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_BISHOP);
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
 
-    const int directions[4] = {9, 7, -7, -9};
+    Bitboard bishops = board.pieces(Us, BISHOP);
+    Bitboard enemy_pieces = board.occupied(Them);
+    Bitboard occupied = board.occupied();
 
     while (bishops) {
         int from = Bitboards::lsb(bishops);
         Bitboards::clear_bit(bishops, from);
 
-        // int from_rank = from / 8;
-        // int from_file = from % 8;
-
-        for (int dir : directions) {
-            int to = from;
-
-            while (true) {
-                int to_rank = to / 8;
-                int to_file = to % 8;
-
-                // Compute new file and rank explicitly
-                int new_rank = to_rank + ((dir > 0) ? 1 : -1);
-                int new_file = to_file + ((dir == 9 || dir == -7) ? 1 : -1);
-
-                // Check clearly: if off-board, stop.
-                if (new_rank < 0 || new_rank > 7 || new_file < 0 || new_file > 7)
-                    break;
-
-                to = new_rank * 8 + new_file;
-
-                // Check clearly: own piece blocking
-                if (Bitboards::get_bit(own_pieces, to))
-                    break;
-
-                moves.push_back({from, to, NO_PIECE});
-
-                // Check clearly: enemy piece blocking (capture and stop)
-                if (Bitboards::get_bit(occupied, to))
-                    break;
-            }
-        }
+        Bitboard attacks = bishop_attacks(from, occupied) & pin_mask(info, from);
+        if constexpr (Type != QUIETS)
+            add_moves(moves, from, attacks & enemy_pieces, CAPTURE);
+        if constexpr (Type != CAPTURES)
+            add_moves(moves, from, attacks & ~occupied, QUIET);
     }
 }
 
 // ------------------- ROOK MOVES ----------------------
-void generate_rook_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Bitboard rooks = board.pieces[us][ROOK];
-    Bitboard own_pieces = board.occupied(us);
-    Bitboard occupied = board.occupied();
+template<Color Us, GenType Type>
+void generate_rook_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_ROOK);
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
 
-    const int directions[4] = {8, -8, 1, -1};  // North, South, East, West
+    Bitboard rooks = board.pieces(Us, ROOK);
+    Bitboard enemy_pieces = board.occupied(Them);
+    Bitboard occupied = board.occupied();
 
     while (rooks) {
         int from = Bitboards::lsb(rooks);
         Bitboards::clear_bit(rooks, from);
 
-        // int from_rank = from / 8;
-        // int from_file = from % 8;
-
-        for (int dir : directions) {
-            int to = from;
-
-            while (true) {
-                int to_rank = to / 8;
-                int to_file = to % 8;
-
-                int new_rank = to_rank;
-                int new_file = to_file;
-
-                if (dir == 8) new_rank += 1;        // North
-                else if (dir == -8) new_rank -= 1;  // South
-                else if (dir == 1) new_file += 1;   // East
-                else if (dir == -1) new_file -= 1;  // West
-
-                // Explicit boundary check
-                if (new_rank < 0 || new_rank > 7 || new_file < 0 || new_file > 7)
-                    break;
-
-                to = new_rank * 8 + new_file;
-
-                if (Bitboards::get_bit(own_pieces, to))
-                    break;
-
-                moves.push_back({from, to, NO_PIECE});
-
-                if (Bitboards::get_bit(occupied, to)) // Stop after capture
-                    break;
-            }
-        }
+        Bitboard attacks = rook_attacks(from, occupied) & pin_mask(info, from);
+        if constexpr (Type != QUIETS)
+            add_moves(moves, from, attacks & enemy_pieces, CAPTURE);
+        if constexpr (Type != CAPTURES)
+            add_moves(moves, from, attacks & ~occupied, QUIET);
     }
 }
 
 // ------------------- QUEEN MOVES ----------------------
-void generate_queen_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Bitboard queens = board.pieces[us][QUEEN];
-    Bitboard own_pieces = board.occupied(us);
-    Bitboard occupied = board.occupied();
+template<Color Us, GenType Type>
+void generate_queen_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_QUEEN);
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
 
-    const int directions[8] = {8, -8, 1, -1, 9, 7, -7, -9};  // Rook + Bishop directions
+    Bitboard queens = board.pieces(Us, QUEEN);
+    Bitboard enemy_pieces = board.occupied(Them);
+    Bitboard occupied = board.occupied();
 
     while (queens) {
         int from = Bitboards::lsb(queens);
         Bitboards::clear_bit(queens, from);
 
-        for (int dir : directions) {
-            int to = from;
-
-            while (true) {
-                int to_rank = to / 8;
-                int to_file = to % 8;
-
-                int new_rank = to_rank;
-                int new_file = to_file;
-
-                if (dir == 8) new_rank += 1;          // North
-                else if (dir == -8) new_rank -= 1;    // South
-                else if (dir == 1) new_file += 1;     // East
-                else if (dir == -1) new_file -= 1;    // West
-                else if (dir == 9) { new_rank += 1; new_file += 1; }  // NE
-                else if (dir == 7) { new_rank += 1; new_file -= 1; }  // NW
-                else if (dir == -7) { new_rank -= 1; new_file += 1; } // SE
-                else if (dir == -9) { new_rank -= 1; new_file -= 1; } // SW
-
-                // Clearly check boundaries
-                if (new_rank < 0 || new_rank > 7 || new_file < 0 || new_file > 7)
-                    break;
-
-                to = new_rank * 8 + new_file;
+        Bitboard attacks = queen_attacks(from, occupied) & pin_mask(info, from);
+        if constexpr (Type != QUIETS)
+            add_moves(moves, from, attacks & enemy_pieces, CAPTURE);
+        if constexpr (Type != CAPTURES)
+            add_moves(moves, from, attacks & ~occupied, QUIET);
+    }
+}
 
-                if (Bitboards::get_bit(own_pieces, to))
-                    break;
+// ------------------- KING MOVES ----------------------
+template<Color Us, GenType Type>
+void generate_king_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_KING);
+    constexpr Color Them = (Us == WHITE) ? BLACK : WHITE;
+
+    int from = info.king_square;
+    Bitboard attacks = king_attacks[from] & ~info.king_danger;
+
+    if constexpr (Type != QUIETS)
+        add_moves(moves, from, attacks & board.occupied(Them), CAPTURE);
+    if constexpr (Type != CAPTURES)
+        add_moves(moves, from, attacks & ~board.occupied(), QUIET);
+}
 
-                moves.push_back({from, to, NO_PIECE});
+template<Color Us>
+void generate_castling_moves(const Board &board, const CheckInfo &info, MoveList &moves) {
+    STATS_INC(GEN_CASTLING);
+    Bitboard targets = castling_targets<Us>(board, info);
 
-                if (Bitboards::get_bit(occupied, to))
-                    break;
-            }
-        }
+    while (targets) {
+        int to = Bitboards::lsb(targets);
+        moves.add(Move(info.king_square, to, to > info.king_square ? KING_CASTLE : QUEEN_CASTLE));
+        Bitboards::clear_bit(targets, to);
     }
 }
 
-void init_king_attacks() {
-    for (int sq = 0; sq < 64; sq++) {
-        Bitboard attacks = EMPTY_BITBOARD;
-        Bitboard bit = (1ULL << sq);
+template<Color Us>
+Bitboard castling_targets(const Board &board, const CheckInfo &info) {
+    // Rights bits, and the squares that must be empty / unattacked, for each wing
+    constexpr int kingside_right  = (Us == WHITE) ? 1 : 4;
+    constexpr int queenside_right = (Us == WHITE) ? 2 : 8;
+    constexpr int rank_shift = (Us == WHITE) ? 0 : 56;
+    constexpr Bitboard kingside_path   = (1ULL << 5 | 1ULL << 6) << rank_shift;             // f, g
+    constexpr Bitboard queenside_empty = (1ULL << 1 | 1ULL << 2 | 1ULL << 3) << rank_shift; // b, c, d
+    constexpr Bitboard queenside_safe  = (1ULL << 2 | 1ULL << 3) << rank_shift;             // c, d
 
-        // Set attacks for king around the square
-        if ((bit << 8) != 0)  attacks |= (bit << 8);   // North
-        if ((bit >> 8) != 0)  attacks |= (bit >> 8);   // South
-        if ((bit << 1) & 0xFEFEFEFEFEFEFEFEULL) attacks |= (bit << 1); // East
-        if ((bit >> 1) & 0x7F7F7F7F7F7F7F7FULL) attacks |= (bit >> 1); // West
+    Bitboard occupied = board.occupied();
+    Bitboard targets = EMPTY_BITBOARD;
 
-        if ((bit << 9) & 0xFEFEFEFEFEFEFEFEULL) attacks |= (bit << 9); // NE
-        if ((bit << 7) & 0x7F7F7F7F7F7F7F7FULL) attacks |= (bit << 7); // NW
-        if ((bit >> 7) & 0x7F7F7F7F7F7F7F7FULL) attacks |= (bit >> 7); // SE
-        if ((bit >> 9) & 0xFEFEFEFEFEFEFEFEULL) attacks |= (bit >> 9); // SW
+    // The king may not castle out of, through or into check
+    if (info.checkers)
+        return targets;
 
-        king_attacks[sq] = attacks;
+    if ((board.castling_rights & kingside_right) &&
+        !(occupied & kingside_path) &&
+        !(info.king_danger & kingside_path)) {
+        Bitboards::set_bit(targets, 6 + rank_shift); // e1->g1 / e8->g8
     }
-}
 
-// ------------------- KING MOVES ----------------------
-void generate_king_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Bitboard kings = board.pieces[us][KING];
-    Bitboard own_pieces = board.occupied(us);
-
-    int from = Bitboards::lsb(kings); // There's only one king
-    Bitboard attacks = king_attacks[from] & ~own_pieces;
-
-    while (attacks) {
-        int to = Bitboards::lsb(attacks);
-        moves.push_back({from, to, NO_PIECE});
-        Bitboards::clear_bit(attacks, to);
+    if ((board.castling_rights & queenside_right) &&
+        !(occupied & queenside_empty) &&
+        !(info.king_danger & queenside_safe)) {
+        Bitboards::set_bit(targets, 2 + rank_shift); // e1->c1 / e8->c8
     }
-}
-
-void generate_castling_moves(const Board &board, std::vector<Move> &moves) {
-    Color us = board.side_to_move;
-    Bitboard occupied = board.occupied();
 
-    if (us == WHITE) {
-        // White Kingside castling
-        if ((board.castling_rights & 1) &&
-            !(occupied & (1ULL << 5 | 1ULL << 6))) {
-            moves.push_back({4, 6, NO_PIECE}); // e1->g1
-        }
-        // White Queenside castling
-        if (board.castling_rights & 2) {
-            if (!(occupied & (1ULL << 1 | 1ULL << 2 | 1ULL << 3))) {
-                moves.push_back({4, 2, NO_PIECE}); // e1->c1
-            }
-        }
-    } else { // BLACK
-        // Black Kingside castling
-        if ((board.castling_rights & 4) &&
-            !(board.occupied() & (1ULL << 57 | 1ULL << 58 | 1ULL << 59))) {
-            moves.push_back({60, 62, NO_PIECE}); // e8->g8
-        }
-        // Black Queenside castling
-        if ((board.castling_rights & 8) && !(board.occupied() & (1ULL << 61 | 1ULL << 62))) {
-            moves.push_back({60, 58, NO_PIECE}); // e8->c8
-        }
-    }
+    return targets;
 }
 
-bool is_square_attacked(const Board& board, int square, Color attacker) {
+template<Color Attacker>
+bool is_square_attacked(const Board& board, int square) {
+    constexpr Color Defender = (Attacker == WHITE) ? BLACK : WHITE;
+    STATS_INC(SQUARE_ATTACKED);
     Bitboard occupied = board.occupied();
 
-    // Pawn attacks
-    Bitboard pawns = board.pieces[attacker][PAWN];
-    Bitboard pawn_attacks = (attacker == WHITE)
-        ? ((pawns << 7) & 0x7F7F7F7F7F7F7F7FULL) | ((pawns << 9) & 0xFEFEFEFEFEFEFEFEULL)
-        : ((pawns >> 7) & 0xFEFEFEFEFEFEFEFEULL) | ((pawns >> 9) & 0x7F7F7F7F7F7F7F7FULL);
-
-    if (pawn_attacks & (1ULL << square)) return true;
+    // Pawn attacks: a defending pawn on the square would attack exactly the attacking pawns
+    if (pawn_attacks[Defender][square] & board.pieces(Attacker, PAWN)) return true;
 
     // Knight attacks
-    Bitboard knights = board.pieces[attacker][KNIGHT];
+    Bitboard knights = board.pieces(Attacker, KNIGHT);
     if (knight_attacks[square] & knights) return true;
 
     // King attacks
-    Bitboard king = board.pieces[attacker][KING];
+    Bitboard king = board.pieces(Attacker, KING);
     if (king_attacks[square] & king) return true;
 
     // Bishop/Queen attacks (diagonals)
-    Bitboard bishopsQueens = board.pieces[attacker][BISHOP] | board.pieces[attacker][QUEEN];
-    const int bishop_dirs[4] = {9, 7, -7, -9};
+    Bitboard bishopsQueens = board.pieces(Attacker, BISHOP, QUEEN);
+    if (bishop_attacks(square, occupied) & bishopsQueens) return true;
 
-    for (int dir : bishop_dirs) {
-        int to = square;
-        while (true) {
-            int to_rank = to / 8;
-            int to_file = to % 8;
+    // Rook/Queen attacks (straight lines)
+    Bitboard rooksQueens = board.pieces(Attacker, ROOK, QUEEN);
+    if (rook_attacks(square, occupied) & rooksQueens) return true;
 
-            int new_rank = to_rank + ((dir > 0) ? 1 : -1);
-            int new_file = to_file + ((dir == 9 || dir == -7) ? 1 : -1);
+    return false;  // Not attacked by any piece
+}
 
-            if (new_rank < 0 || new_rank > 7 || new_file < 0 || new_file > 7) break;
+// ------------------- COLOR DISPATCH ----------------------
+void generate_legal_moves(const Board &board, MoveList &moves) {
+    board.side_to_move == WHITE ? generate_legal_moves<WHITE>(board, moves)
+                                : generate_legal_moves<BLACK>(board, moves);
+}
 
-            to = new_rank * 8 + new_file;
+template<GenType Type>
+void generate(const Board &board, const CheckInfo &info, MoveList &moves) {
+    board.side_to_move == WHITE ? generate_moves<WHITE, Type>(board, info, moves)
+                                : generate_moves<BLACK, Type>(board, info, moves);
+}
 
-            if (Bitboards::get_bit(bishopsQueens, to)) return true;
-            if (Bitboards::get_bit(occupied, to)) break;
-        }
-    }
+template<GenType Type>
+void generate(const Board &board, MoveList &moves) {
+    generate<Type>(board, compute_check_info(board), moves);
+}
 
-    // Rook/Queen attacks (straight lines)
-    Bitboard rooksQueens = board.pieces[attacker][ROOK] | board.pieces[attacker][QUEEN];
-    const int rook_dirs[4] = {8, -8, 1, -1};
+bool is_legal(const Board &board, const CheckInfo &info, Move move) {
+    return board.side_to_move == WHITE ? is_legal<WHITE>(board, info, move)
+                                       : is_legal<BLACK>(board, info, move);
+}
 
-    for (int dir : rook_dirs) {
-        int to = square;
-        while (true) {
-            int to_rank = to / 8;
-            int to_file = to % 8;
+int count_legal_moves(const Board &board) {
+    int count = board.side_to_move == WHITE ? count_legal_moves<WHITE>(board)
+                                            : count_legal_moves<BLACK>(board);
+    STATS_ADD(LEGAL_MOVES, count);
+    return count;
+}
 
-            int new_rank = to_rank;
-            int new_file = to_file;
+CheckInfo compute_check_info(const Board &board) {
+    return board.side_to_move == WHITE ? compute_check_info<WHITE>(board)
+                                       : compute_check_info<BLACK>(board);
+}
 
-            if (dir == 8) new_rank += 1;
-            else if (dir == -8) new_rank -= 1;
-            else if (dir == 1) new_file += 1;
-            else if (dir == -1) new_file -= 1;
+Bitboard attacked_squares(const Board &board, Color attacker, Bitboard occupied) {
+    return attacker == WHITE ? attacked_squares<WHITE>(board, occupied)
+                             : attacked_squares<BLACK>(board, occupied);
+}
 
-            if (new_rank < 0 || new_rank > 7 || new_file < 0 || new_file > 7) break;
+#define DISPATCH_GENERATOR(name)                                                  \
+    void name(const Board &board, const CheckInfo &info, MoveList &moves) {       \
+        board.side_to_move == WHITE ? name<WHITE>(board, info, moves)             \
+                                    : name<BLACK>(board, info, moves);            \
+    }
 
-            to = new_rank * 8 + new_file;
+DISPATCH_GENERATOR(generate_pawn_moves)
+DISPATCH_GENERATOR(generate_knight_moves)
+DISPATCH_GENERATOR(generate_bishop_moves)
+DISPATCH_GENERATOR(generate_rook_moves)
+DISPATCH_GENERATOR(generate_queen_moves)
+DISPATCH_GENERATOR(generate_king_moves)
+DISPATCH_GENERATOR(generate_castling_moves)
 
-            if (Bitboards::get_bit(rooksQueens, to)) return true;
+#undef DISPATCH_GENERATOR
 
-            if (Bitboards::get_bit(occupied, to)) break;
-        }
-    }
+Bitboard en_passant_capturers(const Board &board, const CheckInfo &info) {
+    return board.side_to_move == WHITE ? en_passant_capturers<WHITE>(board, info)
+                                       : en_passant_capturers<BLACK>(board, info);
+}
 
-    return false;  // Not attacked by any piece
+Bitboard castling_targets(const Board &board, const CheckInfo &info) {
+    return board.side_to_move == WHITE ? castling_targets<WHITE>(board, info)
+                                       : castling_targets<BLACK>(board, info);
 }
 
+bool is_square_attacked(const Board& board, int square, Color attacker) {
+    return attacker == WHITE ? is_square_attacked<WHITE>(board, square)
+                             : is_square_attacked<BLACK>(board, square);
+}
+
+// Explicit instantiations, so the side-specialized functions can be called from other files
+#define INSTANTIATE_FOR(C)                                                                        \
+    template void generate_legal_moves<C>(const Board&, MoveList&);                               \
+    template bool is_legal<C>(const Board&, const CheckInfo&, Move);                              \
+    template int count_legal_moves<C>(const Board&);                                              \
+    template CheckInfo compute_check_info<C>(const Board&);                                       \
+    template Bitboard attacked_squares<C>(const Board&, Bitboard);                                \
+    template void generate_pawn_moves<C>(const Board&, const CheckInfo&, MoveList&);              \
+    template void generate_knight_moves<C>(const Board&, const CheckInfo&, MoveList&);            \
+    template void generate_bishop_moves<C>(const Board&, const CheckInfo&, MoveList&);            \
+    template void generate_rook_moves<C>(const Board&, const CheckInfo&, MoveList&);              \
+    template void generate_queen_moves<C>(const Board&, const CheckInfo&, MoveList&);             \
+    template void generate_king_moves<C>(const Board&, const CheckInfo&, MoveList&);              \
+    template void generate_castling_moves<C>(const Board&, const CheckInfo&, MoveList&);          \
+    template Bitboard en_passant_capturers<C>(const Board&, const CheckInfo&);                    \
+    template Bitboard castling_targets<C>(const Board&, const CheckInfo&);                        \
+    template bool is_square_attacked<C>(const Board&, int);
+
+INSTANTIATE_FOR(WHITE)
+INSTANTIATE_FOR(BLACK)
+
+#undef INSTANTIATE_FOR
+
+#define INSTANTIATE_GEN(T)                                                                        \
+    template void generate<T>(const Board&, const CheckInfo&, MoveList&);                         \
+    template void generate<T>(const Board&, MoveList&);                                           \
+    template void generate_moves<WHITE, T>(const Board&, const CheckInfo&, MoveList&);            \
+    template void generate_moves<BLACK, T>(const Board&, const CheckInfo&, MoveList&);
+
+INSTANTIATE_GEN(CAPTURES)
+INSTANTIATE_GEN(QUIETS)
+INSTANTIATE_GEN(EVASIONS)
+INSTANTIATE_GEN(LEGAL)
+
+#undef INSTANTIATE_GEN
+
 }
@@ -1,31 +1,115 @@
 #pragma once
 
 #include "board.h"
+#include "magic.h"
+#include "tables.h"
 #include "types.h"
 #include "util.h"
 
-#include <vector>
-
 namespace MoveGen {
-    uint64_t perft(const Board& board, int depth);
+    // Legality data for the side to move, computed once per position and
+    // shared by every per-piece generator so that only legal moves are emitted
+    struct CheckInfo {
+        int king_square;
+        Bitboard checkers;     // Enemy pieces giving check
+        Bitboard pinned;       // Our pieces pinned against our king
+        Bitboard check_mask;   // Targets that resolve a single check (all squares when not in check)
+        Bitboard king_danger;  // Squares attacked by the enemy, with our king removed from the board
+    };
+
+    // Which moves a generator emits. CAPTURES and QUIETS partition the legal
+    // moves: CAPTURES holds captures, en passant and every promotion (the
+    // moves quiescence search wants), QUIETS the rest including castling.
+    // EVASIONS is meant for positions in check: all legal moves, no castling.
+    enum GenType {
+        CAPTURES,
+        QUIETS,
+        EVASIONS,
+        LEGAL
+    };
+
+    uint64_t perft(Board& board, int depth);
+
+    void generate_legal_moves(const Board& board, MoveList& moves);
+
+    // Staged generation: append only the moves of the given type. The CheckInfo
+    // overload lets several stages share one legality computation.
+    template<GenType Type> void generate(const Board& board, MoveList& moves);
+    template<GenType Type> void generate(const Board& board, const CheckInfo& info, MoveList& moves);
+
+    // Whether move (e.g. from a hash table) is legal in this position
+    bool is_legal(const Board& board, const CheckInfo& info, Move move);
+
+    // Number of legal moves, computed from attack set popcounts without
+    // producing any Move
+    int count_legal_moves(const Board& board);
 
-    std::vector<Move> generate_legal_moves(const Board& board);
+    CheckInfo compute_check_info(const Board& board);
+    Bitboard attacked_squares(const Board& board, Color attacker, Bitboard occupied);
 
     // Individual move generators
-    void generate_pawn_moves(const Board& board, std::vector<Move>& moves);
-    void generate_knight_moves(const Board& board, std::vector<Move>& moves);
-    void generate_bishop_moves(const Board& board, std::vector<Move>& moves);
-    void generate_rook_moves(const Board& board, std::vector<Move>& moves);
-    void generate_queen_moves(const Board& board, std::vector<Move>& moves);
-    void generate_king_moves(const Board& board, std::vector<Move>& moves);
-    void generate_castling_moves(const Board& board, std::vector<Move>& moves);
+    void generate_pawn_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    void generate_knight_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    void generate_bishop_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    void generate_rook_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    void generate_queen_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    void generate_king_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    void generate_castling_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+
+    // Legal en passant capturers and castling king destinations, shared by the
+    // generators and the move counter
+    Bitboard en_passant_capturers(const Board& board, const CheckInfo& info);
+    Bitboard castling_targets(const Board& board, const CheckInfo& info);
 
     bool is_square_attacked(const Board& board, int square, Color attacker);
 
-    // To initialize knight attacks lookup table
-    void init_knight_attacks();
-    void init_king_attacks();
+    // Side-specialized versions of the above. The functions without a template
+    // argument dispatch on board.side_to_move (or the attacker) once and call
+    // these, so the hot path carries no per-color branches.
+    template<Color Us> void generate_legal_moves(const Board& board, MoveList& moves);
+    template<Color Us, GenType Type> void generate_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us> bool is_legal(const Board& board, const CheckInfo& info, Move move);
+    template<Color Us> int count_legal_moves(const Board& board);
+    template<Color Us> CheckInfo compute_check_info(const Board& board);
+    template<Color Attacker> Bitboard attacked_squares(const Board& board, Bitboard occupied);
+    template<Color Us, GenType Type = LEGAL> void generate_pawn_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us, GenType Type = LEGAL> void generate_knight_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us, GenType Type = LEGAL> void generate_bishop_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us, GenType Type = LEGAL> void generate_rook_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us, GenType Type = LEGAL> void generate_queen_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us, GenType Type = LEGAL> void generate_king_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us> void generate_castling_moves(const Board& board, const CheckInfo& info, MoveList& moves);
+    template<Color Us> Bitboard en_passant_capturers(const Board& board, const CheckInfo& info);
+    template<Color Us> Bitboard castling_targets(const Board& board, const CheckInfo& info);
+    template<Color Attacker> bool is_square_attacked(const Board& board, int square);
+
+    // Pawn shifts as seen from color C: one step forward, and the captures
+    // towards the a-file and the h-file
+    template<Color C> constexpr Bitboard pawn_push(Bitboard b) {
+        return C == WHITE ? b << 8 : b >> 8;
+    }
+
+    template<Color C> constexpr Bitboard pawn_attacks_left(Bitboard b) {
+        return (C == WHITE ? b << 7 : b >> 9) & detail::NOT_FILE_H;
+    }
+
+    template<Color C> constexpr Bitboard pawn_attacks_right(Bitboard b) {
+        return (C == WHITE ? b << 9 : b >> 7) & detail::NOT_FILE_A;
+    }
+
+    // Squares attacked by the given pawns of color c
+    template<Color C> constexpr Bitboard pawn_attacks_bb(Bitboard pawns) {
+        return pawn_attacks_left<C>(pawns) | pawn_attacks_right<C>(pawns);
+    }
+
+    inline Bitboard pawn_attacks_bb(Color c, Bitboard pawns) {
+        return c == WHITE ? pawn_attacks_bb<WHITE>(pawns) : pawn_attacks_bb<BLACK>(pawns);
+    }
 
-    extern Bitboard knight_attacks[64];
-    extern Bitboard king_attacks[64];
+    // Legal destination squares for a non-king piece on `from`
+    inline Bitboard pin_mask(const CheckInfo& info, int from) {
+        if (info.pinned & (1ULL << from))
+            return info.check_mask & line_bb[info.king_square][from];
+        return info.check_mask;
+    }
 }
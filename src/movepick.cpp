@@ -0,0 +1,149 @@
+#include "movepick.h"
+
+#include <utility>
+
+namespace {
+
+// Victim values for MVV-LVA ordering, indexed by Piece
+constexpr int piece_value[PIECE_NB] = {0, 100, 320, 330, 500, 900, 20000};
+
+} // namespace
+
+MovePicker::MovePicker(const Board& board, Move tt_move, bool captures_only)
+    : board(board), info(MoveGen::compute_check_info(board)), tt_move(tt_move),
+      captures_only(captures_only), current(0) {
+    if (info.checkers)
+        stage = EVASIONS_INIT;
+    else if (tt_move != Move::none() && (!captures_only || tt_move.is_capture() || tt_move.is_promotion())
+             && MoveGen::is_legal(board, info, tt_move))
+        stage = TT_MOVE;
+    else
+        stage = CAPTURES_INIT;
+
+    // An unusable hash move must not be filtered out of the later stages
+    if (stage != TT_MOVE)
+        this->tt_move = Move::none();
+}
+
+MovePicker::MovePicker(const Board& board, Move tt_move, const Move* killers, const int (*history)[64])
+    : MovePicker(board, tt_move) {
+    this->killers = killers;
+    this->history = history;
+}
+
+// Most valuable victim first, least valuable attacker as tie-break.
+// Promotions count the promoted piece as part of the gain.
+void MovePicker::score_captures() {
+    for (int i = 0; i < moves.size(); i++) {
+        Move m = moves[i];
+        Piece victim = m.flags() == EN_PASSANT ? PAWN : board.board[m.to()];
+        scores[i] = 16 * piece_value[victim] - piece_value[board.board[m.from()]] / 100
+                  + piece_value[m.promotion()];
+    }
+}
+
+// Killer moves first, then history. Killers are only quiet moves, so a
+// killer that is not pseudo-legal here is simply never matched.
+void MovePicker::score_quiets() {
+    for (int i = 0; i < moves.size(); i++) {
+        Move m = moves[i];
+        if (killers && m == killers[0])
+            scores[i] = 2000000;
+        else if (killers && m == killers[1])
+            scores[i] = 1000000;
+        else
+            scores[i] = history ? history[m.from()][m.to()] : 0;
+    }
+}
+
+// Captures first by MVV-LVA, then quiet moves
+void MovePicker::score_evasions() {
+    for (int i = 0; i < moves.size(); i++) {
+        Move m = moves[i];
+        if (m.is_capture() || m.is_promotion()) {
+            Piece victim = m.flags() == EN_PASSANT ? PAWN : board.board[m.to()];
+            scores[i] = 1000000 + 16 * piece_value[victim] - piece_value[board.board[m.from()]] / 100
+                      + piece_value[m.promotion()];
+        } else {
+            scores[i] = 0;
+        }
+    }
+}
+
+Move MovePicker::pick_best() {
+    while (current < moves.size()) {
+        int best = current;
+        for (int i = current + 1; i < moves.size(); i++)
+            if (scores[i] > scores[best])
+                best = i;
+
+        std::swap(moves[current], moves[best]);
+        std::swap(scores[current], scores[best]);
+
+        Move m = moves[current++];
+        if (m != tt_move)
+            return m;
+    }
+    return Move::none();
+}
+
+Move MovePicker::next_move() {
+    Move m;
+
+    switch (stage) {
+        case TT_MOVE:
+            stage = CAPTURES_INIT;
+            return tt_move;
+
+        case CAPTURES_INIT:
+            moves.clear();
+            current = 0;
+            MoveGen::generate<MoveGen::CAPTURES>(board, info, moves);
+            score_captures();
+            stage = CAPTURES;
+            [[fallthrough]];
+
+        case CAPTURES:
+            if ((m = pick_best()) != Move::none())
+                return m;
+            if (captures_only) {
+                stage = DONE;
+                return Move::none();
+            }
+            stage = QUIETS_INIT;
+            [[fallthrough]];
+
+        case QUIETS_INIT:
+            moves.clear();
+            current = 0;
+            MoveGen::generate<MoveGen::QUIETS>(board, info, moves);
+            score_quiets();
+            stage = QUIETS;
+            [[fallthrough]];
+
+        case QUIETS:
+            if ((m = pick_best()) != Move::none())
+                return m;
+            stage = DONE;
+            return Move::none();
+
+        case EVASIONS_INIT:
+            moves.clear();
+            current = 0;
+            MoveGen::generate<MoveGen::EVASIONS>(board, info, moves);
+            score_evasions();
+            stage = EVASIONS;
+            [[fallthrough]];
+
+        case EVASIONS:
+            if ((m = pick_best()) != Move::none())
+                return m;
+            stage = DONE;
+            return Move::none();
+
+        case DONE:
+            break;
+    }
+
+    return Move::none();
+}
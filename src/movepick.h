@@ -0,0 +1,55 @@
+#pragma once
+
+#include "board.h"
+#include "movegen.h"
+#include "types.h"
+
+// Lazy staged move supplier for search. Moves come out in the order
+//   hash move -> captures (most valuable victim first) -> quiet moves
+// and each stage is only generated once the previous one is exhausted, so a
+// beta cutoff on the hash move or a capture never pays for the quiet moves.
+// In check every legal move is generated in a single evasion stage.
+class MovePicker {
+public:
+    // With captures_only set (quiescence search) the quiet stage is skipped,
+    // unless the side to move is in check
+    MovePicker(const Board& board, Move tt_move, bool captures_only = false);
+
+    // Main search: quiet moves are ordered killers first, then by the
+    // history[from][to] scores of the side to move
+    MovePicker(const Board& board, Move tt_move, const Move* killers, const int (*history)[64]);
+
+    // Next move to try, or Move::none() once all stages are exhausted
+    Move next_move();
+
+    const MoveGen::CheckInfo& check_info() const { return info; }
+
+private:
+    enum Stage {
+        TT_MOVE,
+        CAPTURES_INIT, CAPTURES,
+        QUIETS_INIT, QUIETS,
+        EVASIONS_INIT, EVASIONS,
+        DONE
+    };
+
+    // Score the generated moves of the current stage
+    void score_captures();
+    void score_quiets();
+    void score_evasions();
+
+    // Selection-sort step: swap the best remaining move to the front and return it
+    Move pick_best();
+
+    const Board& board;
+    MoveGen::CheckInfo info;
+    Move tt_move;
+    bool captures_only;
+    const Move* killers = nullptr;       // Two killer moves for this ply
+    const int (*history)[64] = nullptr;
+    Stage stage;
+
+    MoveList moves;
+    int scores[MAX_MOVES];
+    int current;
+};
@@ -0,0 +1,257 @@
+#include "nnue.h"
+#include "evaluate.h"
+#include "util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+namespace NNUE {
+
+namespace {
+
+std::unique_ptr<Network> storage;
+
+constexpr char MAGIC[8] = {'H', 'K', 'P', 'N', 'N', 'U', 'E', '1'};
+
+// Every field of Network in file order, as (pointer, size in bytes)
+template<typename Fn>
+void for_each_field(Network& net, Fn fn) {
+    fn(net.ft_bias, sizeof(net.ft_bias));
+    fn(net.ft_weights, sizeof(net.ft_weights));
+    fn(net.l1_bias, sizeof(net.l1_bias));
+    fn(net.l1_weights, sizeof(net.l1_weights));
+    fn(net.l2_bias, sizeof(net.l2_bias));
+    fn(net.l2_weights, sizeof(net.l2_weights));
+    fn(&net.out_bias, sizeof(net.out_bias));
+    fn(net.out_weights, sizeof(net.out_weights));
+}
+
+inline uint8_t clipped_relu(int x) {
+    return static_cast<uint8_t>(std::clamp(x, 0, 127));
+}
+
+// Sum of in[i] * w[i] over n inputs, n a multiple of 32
+inline int32_t dot(const uint8_t* in, const int8_t* w, int n) {
+#if defined(__AVX2__)
+    // u8 x i8 pairs to i16 (no saturation: activations stay below 128), then to i32
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < n; i += 32) {
+        __m256i x = _mm256_load_si256(reinterpret_cast<const __m256i*>(in + i));
+        __m256i y = _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, y), ones));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#elif defined(__SSE2__)
+    // Widen both to i16: inputs with zeros, weights by sign
+    const __m128i zero = _mm_setzero_si128();
+    __m128i s = zero;
+    for (int i = 0; i < n; i += 16) {
+        __m128i x = _mm_load_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m128i y = _mm_load_si128(reinterpret_cast<const __m128i*>(w + i));
+        __m128i ylo = _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8);
+        __m128i yhi = _mm_srai_epi16(_mm_unpackhi_epi8(y, y), 8);
+        s = _mm_add_epi32(s, _mm_madd_epi16(_mm_unpacklo_epi8(x, zero), ylo));
+        s = _mm_add_epi32(s, _mm_madd_epi16(_mm_unpackhi_epi8(x, zero), yhi));
+    }
+#else
+    int32_t sum = 0;
+    for (int i = 0; i < n; i++)
+        sum += in[i] * w[i];
+    return sum;
+#endif
+#if defined(__AVX2__) || defined(__SSE2__)
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+#endif
+}
+
+// One hidden layer: out = clipped_relu((bias + weights * in) >> WEIGHT_SHIFT)
+template<int In, int Out>
+void affine(const uint8_t* in, const int8_t (*weights)[In], const int32_t* bias, uint8_t* out) {
+    static_assert(In % 32 == 0);
+    for (int o = 0; o < Out; o++)
+        out[o] = clipped_relu((bias[o] + dot(in, weights[o], In)) >> WEIGHT_SHIFT);
+}
+
+// The layers after the accumulator, side to move's half first. The output is
+// kept below the bitbase wins, and with them below the mate scores and inside
+// the table's 16-bit fields, whatever the network's weights.
+int forward(const int16_t* us, const int16_t* them) {
+    alignas(64) uint8_t input[2 * L1];
+    alignas(64) uint8_t hidden1[L2];
+    alignas(64) uint8_t hidden2[L3];
+
+    for (int i = 0; i < L1; i++) {
+        input[i] = clipped_relu(us[i]);
+        input[L1 + i] = clipped_relu(them[i]);
+    }
+
+    affine<2 * L1, L2>(input, network->l1_weights, network->l1_bias, hidden1);
+    affine<L2, L3>(hidden1, network->l2_weights, network->l2_bias, hidden2);
+
+    int score = (network->out_bias + dot(hidden2, network->out_weights, L3)) / OUTPUT_SCALE;
+    return std::clamp(score, -Eval::KNOWN_WIN + 1, Eval::KNOWN_WIN - 1);
+}
+
+} // namespace
+
+const Network* network = nullptr;
+
+bool load(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    char magic[8];
+    uint32_t dims[3];
+    if (!f.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return false;
+    if (!f.read(reinterpret_cast<char*>(dims), sizeof(dims)) || dims[0] != L1 || dims[1] != L2 || dims[2] != L3)
+        return false;
+
+    auto net = std::make_unique<Network>();
+    bool ok = true;
+    for_each_field(*net, [&](void* data, size_t size) {
+        ok = ok && f.read(static_cast<char*>(data), size);
+    });
+    if (!ok || f.peek() != std::ifstream::traits_type::eof())
+        return false;
+
+    storage = std::move(net);
+    network = storage.get();
+    return true;
+}
+
+bool save(const std::string& path) {
+    if (!storage)
+        return false;
+
+    std::ofstream f(path, std::ios::binary);
+    uint32_t dims[3] = {L1, L2, L3};
+    f.write(MAGIC, sizeof(MAGIC));
+    f.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    for_each_field(*storage, [&](void* data, size_t size) {
+        f.write(static_cast<const char*>(data), size);
+    });
+    return static_cast<bool>(f.flush());
+}
+
+void unload() {
+    network = nullptr;
+    storage.reset();
+}
+
+// Small weights, so that sums over the 30-odd active inputs stay well inside
+// int16 and the hidden layers neither saturate nor die
+void randomize(uint64_t seed) {
+    auto net = std::make_unique<Network>();
+    PRNG rng{seed ? seed : 1};
+    auto small = [&](int range) { return static_cast<int>(rng.rand() % (2 * range + 1)) - range; };
+
+    for (int16_t& b : net->ft_bias)
+        b = static_cast<int16_t>(small(32));
+    for (auto& row : net->ft_weights)
+        for (int16_t& w : row)
+            w = static_cast<int16_t>(small(16));
+    for (int32_t& b : net->l1_bias)
+        b = small(512);
+    for (auto& row : net->l1_weights)
+        for (int8_t& w : row)
+            w = static_cast<int8_t>(small(8));
+    for (int32_t& b : net->l2_bias)
+        b = small(512);
+    for (auto& row : net->l2_weights)
+        for (int8_t& w : row)
+            w = static_cast<int8_t>(small(32));
+    net->out_bias = 0;
+    for (int8_t& w : net->out_weights)
+        w = static_cast<int8_t>(small(64));
+
+    storage = std::move(net);
+    network = storage.get();
+}
+
+void compute(const Board& board, Color perspective, int16_t* values) {
+    std::memcpy(values, network->ft_bias, sizeof(network->ft_bias));
+    int ksq = board.king_square(perspective);
+
+    for (Color c : {WHITE, BLACK}) {
+        for (int p = PAWN; p < KING; p++) {
+            Bitboard b = board.pieces(c, static_cast<Piece>(p));
+            while (b) {
+                int sq = Bitboards::lsb(b);
+                Bitboards::clear_bit(b, sq);
+                add_row(values, network->ft_weights[input_index(perspective, ksq, c, static_cast<Piece>(p), sq)]);
+            }
+        }
+    }
+}
+
+// Start from the accumulator this perspective had when its king was last on
+// the same square and apply only the pieces that differ since then
+void Accumulator::refresh(const Board& board) {
+    for (Color persp : {WHITE, BLACK}) {
+        if (!dirty[persp])
+            continue;
+        dirty[persp] = false;
+
+        if (!use_cache) {
+            compute(board, persp, values[persp]);
+            continue;
+        }
+
+        int ksq = board.king_square(persp);
+        CacheEntry& entry = cache[persp][ksq];
+        if (!entry.valid) {
+            std::memcpy(entry.values, network->ft_bias, sizeof(entry.values));
+            std::memset(entry.pieces, 0, sizeof(entry.pieces));
+            entry.valid = true;
+        }
+
+        for (Color c : {WHITE, BLACK}) {
+            for (int p = PAWN; p < KING; p++) {
+                Bitboard now = board.pieces(c, static_cast<Piece>(p));
+                Bitboard added = now & ~entry.pieces[c][p];
+                Bitboard removed = entry.pieces[c][p] & ~now;
+                entry.pieces[c][p] = now;
+
+                while (added) {
+                    int sq = Bitboards::lsb(added);
+                    Bitboards::clear_bit(added, sq);
+                    add_row(entry.values, network->ft_weights[input_index(persp, ksq, c, static_cast<Piece>(p), sq)]);
+                }
+                while (removed) {
+                    int sq = Bitboards::lsb(removed);
+                    Bitboards::clear_bit(removed, sq);
+                    sub_row(entry.values, network->ft_weights[input_index(persp, ksq, c, static_cast<Piece>(p), sq)]);
+                }
+            }
+        }
+
+        std::memcpy(values[persp], entry.values, sizeof(entry.values));
+    }
+}
+
+void attach(Board& board, Accumulator* accumulator) {
+    board.accumulator = accumulator;
+    if (accumulator)
+        accumulator->dirty[WHITE] = accumulator->dirty[BLACK] = true;
+}
+
+int evaluate(const Board& board) {
+    Color us = board.side_to_move;
+    Color them = us == WHITE ? BLACK : WHITE;
+
+    if (Accumulator* acc = board.accumulator) {
+        acc->refresh(board);
+        return forward(acc->values[us], acc->values[them]);
+    }
+
+    alignas(64) int16_t values[COLOR_NB][L1];
+    compute(board, WHITE, values[WHITE]);
+    compute(board, BLACK, values[BLACK]);
+    return forward(values[us], values[them]);
+}
+
+}
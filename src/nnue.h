@@ -0,0 +1,213 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+#include <cstdint>
+#include <string>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Quantized HalfKP network evaluation. Each side sees the board from its own
+// king: an input is (own king square, non-king piece and color, square),
+// 40960 per perspective. The first layer turns the active inputs into an
+// accumulator of L1 int16 per perspective, and since a move only switches a
+// few inputs on or off, Board keeps the accumulator up to date by adding and
+// subtracting weight rows as pieces move. Only a king move changes every
+// input of its side; that perspective is marked dirty and rebuilt at the next
+// evaluation, from a cache of accumulators kept per king square, so only
+// the pieces that changed since the king last stood there are applied.
+//
+// The row kernels use AVX2 when compiled with -mavx2 (`make AVX2=1`), SSE2
+// on any other x86-64 build, and plain loops elsewhere.
+namespace NNUE {
+    constexpr int PIECE_INPUTS = 10 * 64;  // Pawn to queen of both colors, on each square
+    constexpr int INPUTS = 64 * PIECE_INPUTS;
+    constexpr int L1 = 128;
+    constexpr int L2 = 32;
+    constexpr int L3 = 32;
+
+    // Clipped ReLU activations are 0..127; hidden sums are scaled down by
+    // 2^WEIGHT_SHIFT, and the output by OUTPUT_SCALE into centipawns
+    constexpr int WEIGHT_SHIFT = 6;
+    constexpr int OUTPUT_SCALE = 16;
+
+    struct Network {
+        alignas(64) int16_t ft_bias[L1];
+        alignas(64) int16_t ft_weights[INPUTS][L1];
+        alignas(64) int32_t l1_bias[L2];
+        alignas(64) int8_t l1_weights[L2][2 * L1];
+        alignas(64) int32_t l2_bias[L3];
+        alignas(64) int8_t l2_weights[L3][L2];
+        int32_t out_bias;
+        alignas(64) int8_t out_weights[L3];
+    };
+
+    // The network every evaluation uses, nullptr until one is loaded
+    extern const Network* network;
+
+    // Network files: "HKPNNUE1", L1, L2 and L3 as uint32, then the fields of
+    // Network in order, little-endian, without padding. Returns false (keeping
+    // the current network) if the file is missing or of another shape.
+    bool load(const std::string& path);
+    bool save(const std::string& path);
+
+    // Back to the classical evaluation
+    void unload();
+
+    // Reproducible random weights, for benchmarks and tests without a file
+    void randomize(uint64_t seed);
+
+    // Input of a piece as seen by `perspective` with its king on ksq. Black
+    // sees the board with the ranks flipped, so both sides share the weights.
+    inline int input_index(Color perspective, int ksq, Color c, Piece p, int square) {
+        int flip = perspective == WHITE ? 0 : 56;
+        int piece = 2 * (p - PAWN) + (c != perspective);
+        return (ksq ^ flip) * PIECE_INPUTS + piece * 64 + (square ^ flip);
+    }
+
+#if defined(__AVX2__)
+    constexpr const char* KERNELS = "AVX2";
+#elif defined(__SSE2__)
+    constexpr const char* KERNELS = "SSE2";
+#else
+    constexpr const char* KERNELS = "scalar";
+#endif
+
+    // acc += add, acc -= sub, or both in one pass, over L1 lanes
+    inline void add_row(int16_t* acc, const int16_t* add) {
+#if defined(__AVX2__)
+        for (int i = 0; i < L1; i += 16) {
+            __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+            *a = _mm256_add_epi16(*a, *reinterpret_cast<const __m256i*>(add + i));
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < L1; i += 8) {
+            __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+            *a = _mm_add_epi16(*a, *reinterpret_cast<const __m128i*>(add + i));
+        }
+#else
+        for (int i = 0; i < L1; i++)
+            acc[i] += add[i];
+#endif
+    }
+
+    inline void sub_row(int16_t* acc, const int16_t* sub) {
+#if defined(__AVX2__)
+        for (int i = 0; i < L1; i += 16) {
+            __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+            *a = _mm256_sub_epi16(*a, *reinterpret_cast<const __m256i*>(sub + i));
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < L1; i += 8) {
+            __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+            *a = _mm_sub_epi16(*a, *reinterpret_cast<const __m128i*>(sub + i));
+        }
+#else
+        for (int i = 0; i < L1; i++)
+            acc[i] -= sub[i];
+#endif
+    }
+
+    inline void add_sub_row(int16_t* acc, const int16_t* add, const int16_t* sub) {
+#if defined(__AVX2__)
+        for (int i = 0; i < L1; i += 16) {
+            __m256i* a = reinterpret_cast<__m256i*>(acc + i);
+            __m256i d = _mm256_sub_epi16(*reinterpret_cast<const __m256i*>(add + i),
+                                         *reinterpret_cast<const __m256i*>(sub + i));
+            *a = _mm256_add_epi16(*a, d);
+        }
+#elif defined(__SSE2__)
+        for (int i = 0; i < L1; i += 8) {
+            __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+            __m128i d = _mm_sub_epi16(*reinterpret_cast<const __m128i*>(add + i),
+                                      *reinterpret_cast<const __m128i*>(sub + i));
+            *a = _mm_add_epi16(*a, d);
+        }
+#else
+        for (int i = 0; i < L1; i++)
+            acc[i] += add[i] - sub[i];
+#endif
+    }
+
+    // Accumulator of one perspective as it was when its king last stood on
+    // a square, with the pieces it was computed for
+    struct CacheEntry {
+        alignas(64) int16_t values[L1];
+        Bitboard pieces[COLOR_NB][PIECE_NB];
+        bool valid;
+    };
+
+    // First-layer state of one board. Owned by whoever evaluates (a search
+    // thread) and attached to its Board, which then updates it in
+    // put/remove/move_piece. Requires a loaded network.
+    struct Accumulator {
+        alignas(64) int16_t values[COLOR_NB][L1];
+        bool dirty[COLOR_NB] = {true, true};
+
+        // Rebuild dirty perspectives from the king-square cache instead of
+        // from scratch
+        bool use_cache = true;
+        CacheEntry cache[COLOR_NB][64] = {};
+
+        // A king only enters or leaves while setting up; rebuild its side
+        void put_piece(const Board& board, Color c, Piece p, int square) {
+            if (p == KING) {
+                dirty[c] = true;
+                return;
+            }
+            for (Color persp : {WHITE, BLACK}) {
+                if (dirty[persp])
+                    continue;
+                // No king to see the piece from yet: leave it to refresh
+                int ksq = board.king_square(persp);
+                if (ksq < 0) {
+                    dirty[persp] = true;
+                    continue;
+                }
+                add_row(values[persp], network->ft_weights[input_index(persp, ksq, c, p, square)]);
+            }
+        }
+
+        void remove_piece(const Board& board, Color c, Piece p, int square) {
+            if (p == KING) {
+                dirty[c] = true;
+                return;
+            }
+            for (Color persp : {WHITE, BLACK})
+                if (!dirty[persp])
+                    sub_row(values[persp], network->ft_weights[input_index(persp, board.king_square(persp), c, p, square)]);
+        }
+
+        void move_piece(const Board& board, Color c, Piece p, int from, int to) {
+            if (p == KING) {
+                dirty[c] = true;
+                return;
+            }
+            for (Color persp : {WHITE, BLACK}) {
+                if (dirty[persp])
+                    continue;
+                int ksq = board.king_square(persp);
+                add_sub_row(values[persp], network->ft_weights[input_index(persp, ksq, c, p, to)],
+                            network->ft_weights[input_index(persp, ksq, c, p, from)]);
+            }
+        }
+
+        // Bring dirty perspectives up to date
+        void refresh(const Board& board);
+    };
+
+    // Attach a fresh accumulator to the board (or detach with nullptr)
+    void attach(Board& board, Accumulator* accumulator);
+
+    // First-layer output of `perspective` computed from scratch
+    void compute(const Board& board, Color perspective, int16_t* values);
+
+    // Score in centipawns from the side to move's point of view, strictly
+    // inside +-Eval::KNOWN_WIN. Uses the board's accumulator, refreshing it
+    // if needed, or computes the first layer from scratch if the board has
+    // none.
+    int evaluate(const Board& board);
+}
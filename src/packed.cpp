@@ -0,0 +1,202 @@
+#include "packed.h"
+#include "nnue.h"
+#include "worksteal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Packed {
+
+bool pack(const Board& board, PackedPosition& record) {
+    std::memset(&record, 0, sizeof(record));
+
+    Bitboard occupied = board.occupied();
+    if (Bitboards::popcount(occupied) > 32)
+        return false;
+
+    record.occupied = occupied;
+
+    int n = 0;
+    while (occupied) {
+        int sq = Bitboards::lsb(occupied);
+        Bitboards::clear_bit(occupied, sq);
+
+        int color = Bitboards::get_bit(board.occupied(BLACK), sq) ? BLACK : WHITE;
+        uint8_t nibble = static_cast<uint8_t>(color << 3 | board.board[sq]);
+        record.pieces[n / 2] |= (n % 2) ? nibble << 4 : nibble;
+        n++;
+    }
+
+    record.flags = static_cast<uint8_t>(board.castling_rights | (board.side_to_move == BLACK ? 0x80 : 0));
+    record.en_passant = board.en_passant_square == -1 ? 0xFF : static_cast<uint8_t>(board.en_passant_square);
+    record.halfmove_clock = static_cast<uint8_t>(std::min(board.halfmove_clock, 255));
+    record.fullmove_number = static_cast<uint16_t>(std::min(board.fullmove_number, 65535));
+    return true;
+}
+
+// Built on a scratch board, so that a rejected record leaves `board` as it was
+bool unpack(const PackedPosition& record, Board& board) {
+    Board b;
+    for (int p = ALL_PIECES; p < PIECE_NB; p++)
+        b.by_type[p] = EMPTY_BITBOARD;
+    b.by_color[WHITE] = b.by_color[BLACK] = EMPTY_BITBOARD;
+    for (int sq = 0; sq < 64; sq++)
+        b.board[sq] = NO_PIECE;
+
+    // put_piece also updates the keys and eval sums, recomputed below anyway
+    b.key = b.pawn_key = 0ULL;
+    b.psq_mg = b.psq_eg = b.phase = 0;
+
+    Bitboard occupied = record.occupied;
+    int n = 0;
+    while (occupied) {
+        int sq = Bitboards::lsb(occupied);
+        Bitboards::clear_bit(occupied, sq);
+        if (n >= 32)
+            return false;
+
+        uint8_t nibble = (record.pieces[n / 2] >> (4 * (n % 2))) & 0xF;
+        int piece = nibble & 7;
+        if (piece == NO_PIECE || piece >= PIECE_NB)
+            return false;
+        if (piece == PAWN && (sq < 8 || sq >= 56))
+            return false;
+        b.put_piece(static_cast<Color>(nibble >> 3), static_cast<Piece>(piece), sq);
+        n++;
+    }
+
+    if (Bitboards::popcount(b.pieces(WHITE, KING)) != 1 || Bitboards::popcount(b.pieces(BLACK, KING)) != 1)
+        return false;
+
+    if (record.flags & 0x70)
+        return false;
+    b.side_to_move = (record.flags & 0x80) ? BLACK : WHITE;
+
+    // pack only writes rights whose king and rook are still at home
+    b.castling_rights = record.flags & 0xF;
+    struct { int right; Color c; int king, rook; } homes[] = {
+        { 1, WHITE, 4, 7 }, { 2, WHITE, 4, 0 }, { 4, BLACK, 60, 63 }, { 8, BLACK, 60, 56 }
+    };
+    for (const auto& h : homes)
+        if ((b.castling_rights & h.right)
+            && (!Bitboards::get_bit(b.pieces(h.c, KING), h.king) || !Bitboards::get_bit(b.pieces(h.c, ROOK), h.rook)))
+            return false;
+
+    // An empty square on the sixth rank of the side to move, passed over by
+    // the enemy pawn in front of it
+    b.en_passant_square = -1;
+    if (record.en_passant != 0xFF) {
+        int ep = record.en_passant;
+        Color them = b.side_to_move == WHITE ? BLACK : WHITE;
+        int pawn = b.side_to_move == WHITE ? ep - 8 : ep + 8;
+        if (ep >= 64 || ep / 8 != (b.side_to_move == WHITE ? 5 : 2)
+            || Bitboards::get_bit(b.occupied(), ep) || !Bitboards::get_bit(b.pieces(them, PAWN), pawn))
+            return false;
+        b.en_passant_square = ep;
+    }
+
+    b.halfmove_clock = record.halfmove_clock;
+    b.fullmove_number = record.fullmove_number;
+
+    b.key = b.compute_key();
+    b.pawn_key = b.compute_pawn_key();
+    b.compute_psq();
+
+    // The scratch board had no accumulator: the attached one is rebuilt
+    b.accumulator = board.accumulator;
+    board = b;
+    if (board.accumulator)
+        board.accumulator->dirty[WHITE] = board.accumulator->dirty[BLACK] = true;
+    return true;
+}
+
+bool Reader::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size % sizeof(PackedPosition) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(st.st_size);
+    count = length / sizeof(PackedPosition);
+    if (length == 0) {
+        ::close(fd);
+        return true;
+    }
+
+    void* map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file referenced
+    if (map == MAP_FAILED) {
+        count = length = 0;
+        return false;
+    }
+
+    // Records are mostly streamed front to back
+    madvise(map, length, MADV_SEQUENTIAL);
+    records = static_cast<const PackedPosition*>(map);
+    return true;
+}
+
+void Reader::close() {
+    if (records)
+        munmap(const_cast<PackedPosition*>(records), length);
+    records = nullptr;
+    count = length = 0;
+}
+
+bool Writer::open(const std::string& path) {
+    close();
+    file = std::fopen(path.c_str(), "wb");
+    ok = file != nullptr;
+    if (file)
+        std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+    return ok;
+}
+
+bool Writer::write(const PackedPosition& record) {
+    if (file && std::fwrite(&record, sizeof(record), 1, file) == 1)
+        return true;
+    ok = false;
+    return false;
+}
+
+// A board that does not fit a record is the caller's to skip; it says
+// nothing about the file, so it leaves `ok` alone
+bool Writer::write(const Board& board) {
+    PackedPosition record;
+    return pack(board, record) && write(record);
+}
+
+bool Writer::close() {
+    if (file) {
+        if (std::fclose(file) != 0)
+            ok = false;
+        file = nullptr;
+    }
+    return ok;
+}
+
+void for_each_parallel(const Reader& reader, int threads,
+                       const std::function<void(const PackedPosition& record, size_t index, int worker)>& fn) {
+    // 64 KB of records per task
+    constexpr size_t CHUNK = 2048;
+    size_t chunks = (reader.size() + CHUNK - 1) / CHUNK;
+
+    WorkStealing::run(chunks, std::max(threads, 1), [&](size_t chunk, int worker) {
+        size_t end = std::min(reader.size(), (chunk + 1) * CHUNK);
+        for (size_t i = chunk * CHUNK; i < end; i++)
+            fn(reader[i], i, worker);
+    });
+}
+
+}
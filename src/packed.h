@@ -0,0 +1,90 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+// Fixed-size binary position records for large datasets. A file is a plain
+// array of PackedPosition in host (little-endian) byte order, with no
+// header, so it can be memory-mapped and indexed directly.
+namespace Packed {
+    struct PackedPosition {
+        Bitboard occupied;
+        // One nibble per set bit of `occupied`, lowest square first, low
+        // nibble first: color << 3 | piece
+        uint8_t pieces[16];
+        uint8_t flags;            // Castling rights in bits 0-3, black to move in bit 7
+        uint8_t en_passant;       // En passant square, or 0xFF if none
+        uint8_t halfmove_clock;
+        uint8_t reserved;         // Zero
+        uint16_t fullmove_number;
+        uint16_t label;           // Free for the dataset (e.g. a score); pack writes 0
+    };
+
+    static_assert(sizeof(PackedPosition) == 32, "PackedPosition must stay 32 bytes");
+
+    // Returns false if the board holds more than 32 pieces
+    bool pack(const Board& board, PackedPosition& record);
+
+    // Returns false, leaving board unchanged, if the record is not a valid
+    // position: a bad nibble, not exactly one king per side, a pawn on the
+    // first or last rank, a castling right without its king and rook at
+    // home, or an en passant square not behind an enemy pawn
+    bool unpack(const PackedPosition& record, Board& board);
+
+    // Read-only memory mapping of a record file. Records are used in place:
+    // nothing is copied or parsed until unpack is called on one.
+    class Reader {
+    public:
+        Reader() = default;
+        ~Reader() { close(); }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        // Returns false if the file cannot be mapped or its size is not a
+        // multiple of the record size
+        bool open(const std::string& path);
+        void close();
+
+        size_t size() const { return count; }
+        const PackedPosition& operator[](size_t i) const { return records[i]; }
+        const PackedPosition* begin() const { return records; }
+        const PackedPosition* end() const { return records + count; }
+
+    private:
+        const PackedPosition* records = nullptr;
+        size_t count = 0;
+        size_t length = 0;
+    };
+
+    // Buffered appending writer
+    class Writer {
+    public:
+        Writer() = default;
+        ~Writer() { close(); }
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool open(const std::string& path);
+        bool write(const PackedPosition& record);
+        // Returns false if the board cannot be packed (more than 32 pieces)
+        // or the write failed; only the latter makes close() fail
+        bool write(const Board& board);
+        // Flushes; returns false if any write or the flush failed
+        bool close();
+
+    private:
+        FILE* file = nullptr;
+        bool ok = true;
+    };
+
+    // Call fn(record, index, worker) for every record on `threads` threads.
+    // Records are handed out in chunks through WorkStealing::run, so workers
+    // walk the mapping sequentially and uneven per-record work still balances.
+    void for_each_parallel(const Reader& reader, int threads,
+                           const std::function<void(const PackedPosition& record, size_t index, int worker)>& fn);
+}
@@ -0,0 +1,92 @@
+#include "pawns.h"
+
+#include <array>
+
+namespace Pawns {
+
+namespace {
+
+constexpr Bitboard FILE_A = 0x0101010101010101ULL;
+
+// Bonuses in centipawns: {middlegame, endgame}
+constexpr int doubled[2] = {-11, -51};
+constexpr int isolated[2] = {-5, -15};
+constexpr int passed[8][2] = {
+    {0, 0}, {5, 10}, {10, 17}, {15, 30}, {30, 55}, {50, 95}, {80, 150}, {0, 0}
+};
+
+constexpr Bitboard file_bb(int file) { return FILE_A << file; }
+
+constexpr Bitboard adjacent_files_bb(int file) {
+    return (file > 0 ? file_bb(file - 1) : 0) | (file < 7 ? file_bb(file + 1) : 0);
+}
+
+// Squares in front of a pawn, on its own and the adjacent files. A pawn
+// with no enemy pawns in this span is passed.
+constexpr std::array<std::array<Bitboard, 64>, COLOR_NB> make_passed_spans() {
+    std::array<std::array<Bitboard, 64>, COLOR_NB> spans{};
+    for (int sq = 0; sq < 64; sq++) {
+        Bitboard files = file_bb(sq % 8) | adjacent_files_bb(sq % 8);
+        int rank = sq / 8;
+        Bitboard above = rank < 7 ? ~0ULL << (8 * (rank + 1)) : 0;
+        Bitboard below = rank > 0 ? ~0ULL >> (8 * (8 - rank)) : 0;
+        spans[WHITE][sq] = files & above;
+        spans[BLACK][sq] = files & below;
+    }
+    return spans;
+}
+
+constexpr auto passed_span = make_passed_spans();
+
+} // namespace
+
+void evaluate(const Board& board, Entry& e) {
+    int score[COLOR_NB][2] = {};
+    e.passed = EMPTY_BITBOARD;
+
+    for (Color us : {WHITE, BLACK}) {
+        Color them = (us == WHITE) ? BLACK : WHITE;
+        Bitboard ours = board.pieces(us, PAWN);
+        Bitboard theirs = board.pieces(them, PAWN);
+
+        Bitboard bb = ours;
+        while (bb) {
+            int sq = Bitboards::lsb(bb);
+            Bitboards::clear_bit(bb, sq);
+            int file = sq % 8;
+            int relative_rank = (us == WHITE) ? sq / 8 : 7 - sq / 8;
+
+            // Only the rearmost pawn of a doubled pair is penalized
+            Bitboard ahead = passed_span[us][sq] & file_bb(file);
+            if (ours & ahead) {
+                score[us][0] += doubled[0];
+                score[us][1] += doubled[1];
+            }
+
+            if (!(ours & adjacent_files_bb(file))) {
+                score[us][0] += isolated[0];
+                score[us][1] += isolated[1];
+            }
+
+            if (!(theirs & passed_span[us][sq]) && !(ours & ahead)) {
+                Bitboards::set_bit(e.passed, sq);
+                score[us][0] += passed[relative_rank][0];
+                score[us][1] += passed[relative_rank][1];
+            }
+        }
+    }
+
+    e.mg = static_cast<int16_t>(score[WHITE][0] - score[BLACK][0]);
+    e.eg = static_cast<int16_t>(score[WHITE][1] - score[BLACK][1]);
+}
+
+const Entry& Table::probe(const Board& board) {
+    Entry& e = entries[board.pawn_key & (SIZE - 1)];
+    if (e.key != board.pawn_key) {
+        e.key = board.pawn_key;
+        evaluate(board, e);
+    }
+    return e;
+}
+
+}
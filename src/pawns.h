@@ -0,0 +1,34 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+#include <vector>
+
+// Pawn structure evaluation cached by pawn-only Zobrist key. Pawn structure
+// changes on few moves, so most probes during a search are hits.
+namespace Pawns {
+    struct Entry {
+        uint64_t key;
+        int16_t mg;  // Pawn structure terms from white's point of view
+        int16_t eg;
+        Bitboard passed;  // Passed pawns of both colors
+    };
+
+    // Direct-mapped, one table per search thread
+    class Table {
+    public:
+        static constexpr size_t SIZE = 1 << 14;
+
+        Table() : entries(SIZE) {}
+
+        // Entry for the board's pawn structure, computed on a miss
+        const Entry& probe(const Board& board);
+
+    private:
+        std::vector<Entry> entries;
+    };
+
+    // Evaluate the pawn structure from scratch into e
+    void evaluate(const Board& board, Entry& e);
+}
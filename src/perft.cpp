@@ -0,0 +1,416 @@
+#include "perft.h"
+#include "movegen.h"
+#include "worksteal.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Perft {
+
+namespace {
+
+// Cache file layout: this header, padded to a page, then the buckets
+struct FileHeader {
+    char magic[8];
+    uint64_t version;
+    uint64_t bucket_count;
+    uint64_t fingerprint;
+};
+
+constexpr size_t HEADER_SIZE = 4096;
+constexpr char MAGIC[8] = {'P', 'E', 'R', 'F', 'T', 'B', 'L', '\0'};
+constexpr uint64_t VERSION = 1;
+
+// Changes whenever the Zobrist keys do, so a cache written by a build with
+// other keys is never trusted
+constexpr uint64_t FINGERPRINT = Zobrist::detail::keys.side
+                               ^ Zobrist::detail::keys.psq[WHITE][KING][4]
+                               ^ Zobrist::detail::keys.castling[15];
+
+size_t bucket_count(size_t megabytes, size_t bucket_size) {
+    size_t count = 1;
+    while (count * 2 * bucket_size <= megabytes * 1024 * 1024)
+        count *= 2;
+    return count;
+}
+
+uint64_t load(const uint64_t& word) {
+    return std::atomic_ref<const uint64_t>(word).load(std::memory_order_relaxed);
+}
+
+void store_word(uint64_t& word, uint64_t value) {
+    std::atomic_ref<uint64_t>(word).store(value, std::memory_order_relaxed);
+}
+
+} // namespace
+
+PerftTable::PerftTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+void PerftTable::resize(size_t megabytes) {
+    unmap();
+
+    size_t count = bucket_count(megabytes, sizeof(Bucket));
+    memory.assign(count, Bucket{});
+    buckets = memory.data();
+    mask = count - 1;
+}
+
+bool PerftTable::open(const std::string& path, size_t megabytes) {
+    size_t count = bucket_count(megabytes, sizeof(Bucket));
+    size_t length = HEADER_SIZE + count * sizeof(Bucket);
+
+    // An existing cache is adopted as is if it has the right size, and
+    // otherwise only read from, to carry its entries over
+    const Bucket* old_buckets = nullptr;
+    size_t old_count = 0;
+    void* old_map = MAP_FAILED;
+    size_t old_length = 0;
+
+    int fd = ::open(path.c_str(), O_RDWR);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= HEADER_SIZE) {
+            old_length = static_cast<size_t>(st.st_size);
+            old_map = mmap(nullptr, old_length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+
+        if (old_map != MAP_FAILED) {
+            const FileHeader* h = static_cast<const FileHeader*>(old_map);
+            bool valid = std::memcmp(h->magic, MAGIC, sizeof(MAGIC)) == 0 && h->version == VERSION
+                      && h->fingerprint == FINGERPRINT
+                      && old_length == HEADER_SIZE + h->bucket_count * sizeof(Bucket);
+
+            if (valid && h->bucket_count == count) {
+                unmap();
+                mapping = old_map;
+                mapping_length = old_length;
+                buckets = reinterpret_cast<Bucket*>(static_cast<char*>(old_map) + HEADER_SIZE);
+                mask = count - 1;
+                return true;
+            }
+            if (valid) {
+                old_buckets = reinterpret_cast<const Bucket*>(static_cast<const char*>(old_map) + HEADER_SIZE);
+                old_count = h->bucket_count;
+            }
+        }
+    }
+
+    // Build the new file aside: a sparse file of zeros is an empty table
+    std::string tmp = path + ".tmp." + std::to_string(getpid());
+    fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    void* map = MAP_FAILED;
+    if (fd >= 0) {
+        if (ftruncate(fd, static_cast<off_t>(length)) == 0)
+            map = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+    }
+    if (map == MAP_FAILED) {
+        if (old_map != MAP_FAILED)
+            munmap(old_map, old_length);
+        ::unlink(tmp.c_str());
+        return false;
+    }
+
+    unmap();
+    mapping = map;
+    mapping_length = length;
+    buckets = reinterpret_cast<Bucket*>(static_cast<char*>(map) + HEADER_SIZE);
+    mask = count - 1;
+
+    // Rehash the old entries; when shrinking, the deepest survive
+    for (size_t b = 0; b < old_count; b++) {
+        for (const Entry& e : old_buckets[b].entries) {
+            uint64_t data = load(e.data);
+            if (data & 0xFF)
+                store(load(e.key) ^ data, static_cast<int>(data & 0xFF), data >> 8);
+        }
+    }
+    if (old_map != MAP_FAILED)
+        munmap(old_map, old_length);
+
+    // The header goes in last and the file is flushed before it replaces
+    // the old one
+    FileHeader* h = static_cast<FileHeader*>(map);
+    std::memcpy(h->magic, MAGIC, sizeof(MAGIC));
+    h->version = VERSION;
+    h->bucket_count = count;
+    h->fingerprint = FINGERPRINT;
+    msync(map, length, MS_SYNC);
+
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        ::unlink(tmp.c_str());
+        resize(megabytes);
+        return false;
+    }
+    return true;
+}
+
+void PerftTable::unmap() {
+    if (mapping)
+        munmap(mapping, mapping_length);
+    mapping = nullptr;
+    mapping_length = 0;
+    buckets = nullptr;
+}
+
+void PerftTable::clear() {
+    std::fill(buckets, buckets + mask + 1, Bucket{});
+}
+
+bool PerftTable::probe(uint64_t key, int depth, uint64_t& nodes) const {
+    for (const Entry& e : bucket(key).entries) {
+        uint64_t data = load(e.data);
+        if ((load(e.key) ^ data) == key && static_cast<int>(data & 0xFF) == depth) {
+            nodes = data >> 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerftTable::store(uint64_t key, int depth, uint64_t nodes) {
+    Entry* replace = nullptr;
+    for (Entry& e : bucket(key).entries) {
+        uint64_t data = load(e.data);
+        if ((load(e.key) ^ data) == key && static_cast<int>(data & 0xFF) == depth) {
+            replace = &e;
+            break;
+        }
+        if (!replace || (data & 0xFF) < (load(replace->data) & 0xFF))
+            replace = &e;
+    }
+
+    uint64_t data = (nodes << 8) | static_cast<uint64_t>(depth);
+    store_word(replace->data, data);
+    store_word(replace->key, key ^ data);
+}
+
+uint64_t perft(Board& board, int depth, PerftTable& table) {
+    if (depth == 0)
+        return 1ULL;
+
+    // Counting the frontier is cheaper than a table probe
+    if (depth == 1)
+        return MoveGen::count_legal_moves(board);
+
+    uint64_t nodes = 0ULL;
+    if (table.probe(board.key, depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    MoveGen::generate_legal_moves(board, moves);
+
+    for (const Move& move : moves) {
+        StateInfo st;
+        board.make_move(move, st);
+        nodes += perft(board, depth - 1, table);
+        board.unmake_move(move, st);
+    }
+
+    table.store(board.key, depth, nodes);
+    return nodes;
+}
+
+uint64_t divide(Board& board, int depth, std::ostream& out) {
+    using Clock = std::chrono::steady_clock;
+
+    MoveList moves;
+    MoveGen::generate_legal_moves(board, moves);
+
+    uint64_t total = 0ULL;
+    Clock::time_point start = Clock::now();
+
+    for (const Move& move : moves) {
+        Clock::time_point move_start = Clock::now();
+
+        StateInfo st;
+        board.make_move(move, st);
+        uint64_t nodes = depth > 1 ? MoveGen::perft(board, depth - 1) : 1ULL;
+        board.unmake_move(move, st);
+
+        double seconds = std::chrono::duration<double>(Clock::now() - move_start).count();
+        out << move_to_string(move) << ": " << nodes << " (" << seconds << "s)\n";
+        total += nodes;
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    out << "\nMoves: " << moves.size() << "\n";
+    out << "Nodes: " << total << "\n";
+    out << "Time: " << seconds << "s\n";
+    out << "NPS: " << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0) << "\n";
+
+    return total;
+}
+
+bool run_suite(const std::string& path, int max_depth, std::ostream& out, PerftTable* table) {
+    using Clock = std::chrono::steady_clock;
+
+    std::ifstream file(path);
+    if (!file) {
+        out << "Cannot open " << path << "\n";
+        return false;
+    }
+
+    int passed = 0, failed = 0, skipped = 0;
+    uint64_t total_nodes = 0ULL;
+    double total_seconds = 0.0;
+    std::string line;
+
+    while (std::getline(file, line)) {
+        size_t fields = line.find(';');
+        if (line.empty() || line[0] == '#' || fields == std::string::npos)
+            continue;
+
+        Board board;
+        std::string fen = line.substr(0, line.find_last_not_of(' ', fields - 1) + 1);
+        if (!board.set_fen(fen)) {
+            out << "FAIL  bad FEN: " << fen << "\n";
+            failed++;
+            continue;
+        }
+
+        bool ok = true, malformed = false;
+        int depths_run = 0;
+        uint64_t nodes = 0ULL;
+        double seconds = 0.0;
+        std::string detail;
+
+        // Each field is "D<depth> <expected nodes>"; other opcodes are ignored
+        std::istringstream ss(line.substr(fields));
+        std::string field;
+        while (std::getline(ss, field, ';')) {
+            std::istringstream fs(field);
+            std::string tag;
+            if (!(fs >> tag) || tag[0] != 'D')
+                continue;
+
+            int depth = 0;
+            uint64_t expected = 0;
+            const char* last = tag.data() + tag.size();
+            auto [end, ec] = std::from_chars(tag.data() + 1, last, depth);
+            if (ec != std::errc() || end != last || depth < 1 || !(fs >> expected)) {
+                malformed = true;
+                detail = field.substr(0, field.find_last_not_of(" ") + 1);
+                break;
+            }
+            if (depth > max_depth)
+                continue;
+
+            Clock::time_point start = Clock::now();
+            uint64_t result = table ? perft(board, depth, *table) : MoveGen::perft(board, depth);
+            seconds += std::chrono::duration<double>(Clock::now() - start).count();
+            nodes += result;
+            depths_run++;
+
+            if (result != expected) {
+                ok = false;
+                detail += " D" + std::to_string(depth) + " got " + std::to_string(result)
+                        + " expected " + std::to_string(expected);
+            }
+        }
+
+        if (malformed) {
+            out << "FAIL  malformed field \"" << detail << "\": " << line << "\n";
+            failed++;
+            continue;
+        }
+        if (depths_run == 0) {
+            out << "SKIP  " << fen << "  no depth within " << max_depth << "\n";
+            skipped++;
+            continue;
+        }
+
+        out << (ok ? "PASS  " : "FAIL  ") << fen << "  nodes " << nodes
+            << "  nps " << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0) << detail << "\n";
+
+        ok ? passed++ : failed++;
+        total_nodes += nodes;
+        total_seconds += seconds;
+    }
+
+    out << "\n" << passed << " passed, " << failed << " failed";
+    if (skipped)
+        out << ", " << skipped << " skipped";
+    out << "\n";
+    out << "Nodes: " << total_nodes << "  Time: " << total_seconds << "s  NPS: "
+        << static_cast<uint64_t>(total_seconds > 0 ? total_nodes / total_seconds : 0) << "\n";
+
+    return failed == 0;
+}
+
+namespace {
+
+struct Task {
+    Board board;
+    int depth;
+};
+
+// Collect the positions split_depth plies below board as tasks
+void split(Board& board, int depth, int split_depth, std::vector<Task>& tasks) {
+    if (split_depth == 0) {
+        tasks.push_back({board, depth});
+        return;
+    }
+
+    MoveList moves;
+    MoveGen::generate_legal_moves(board, moves);
+
+    for (const Move& move : moves) {
+        StateInfo st;
+        board.make_move(move, st);
+        split(board, depth - 1, split_depth - 1, tasks);
+        board.unmake_move(move, st);
+    }
+}
+
+} // namespace
+
+uint64_t perft_parallel(const Board& board, int depth, int threads, int split_depth, size_t hash_mb) {
+    if (threads < 1)
+        threads = 1;
+
+    // Leave at least one ply below the split so every task does real work
+    if (split_depth > depth - 1)
+        split_depth = depth - 1;
+    if (split_depth < 0)
+        return 1ULL;
+
+    Board root = board;
+    std::vector<Task> tasks;
+    split(root, depth, split_depth, tasks);
+
+    std::vector<Counter> counters(threads);
+    std::vector<std::unique_ptr<PerftTable>> tables(threads);
+    if (hash_mb > 0)
+        for (auto& table : tables)
+            table = std::make_unique<PerftTable>(hash_mb / threads);
+
+    WorkStealing::run(tasks.size(), threads, [&](size_t i, int worker) {
+        Board& task_board = tasks[i].board;
+        if (tables[worker])
+            counters[worker].nodes += perft(task_board, tasks[i].depth, *tables[worker]);
+        else
+            counters[worker].nodes += MoveGen::perft(task_board, tasks[i].depth);
+    });
+
+    uint64_t nodes = 0ULL;
+    for (const Counter& c : counters)
+        nodes += c.nodes;
+    return nodes;
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "board.h"
+#include "types.h"
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Perft {
+    // Fixed-size hash table of subtree node counts keyed by (Zobrist key, depth).
+    // The table is a power-of-two array of 64-byte buckets holding four entries
+    // each, so a probe touches a single cache line. Each entry stores its key
+    // XORed with its data word, so an entry torn by a concurrent writer or a
+    // crash reads as a miss instead of a wrong count.
+    class PerftTable {
+    public:
+        explicit PerftTable(size_t megabytes);
+        ~PerftTable() { unmap(); }
+        PerftTable(const PerftTable&) = delete;
+        PerftTable& operator=(const PerftTable&) = delete;
+
+        // Reallocate in memory to the largest power-of-two bucket count
+        // fitting the budget
+        void resize(size_t megabytes);
+
+        // Keep the table in a memory-mapped file instead, so counts survive
+        // across runs and can be shared by processes. A valid file of another
+        // size has its entries rehashed into the new size, which caps the
+        // file at `megabytes`. A new file is built under a temporary name and
+        // renamed into place, so a crash never leaves a half-made cache.
+        // Returns false (leaving the table in memory) if the file cannot be
+        // created or mapped.
+        bool open(const std::string& path, size_t megabytes);
+
+        void clear();
+
+        bool probe(uint64_t key, int depth, uint64_t& nodes) const;
+
+        // Replaces the shallowest entry of the bucket: it is the cheapest
+        // subtree to recount
+        void store(uint64_t key, int depth, uint64_t nodes);
+
+    private:
+        // Node count in the upper 56 bits, remaining depth in the low 8 bits
+        struct Entry {
+            uint64_t key;   // Zobrist key ^ data
+            uint64_t data;
+        };
+
+        struct alignas(64) Bucket {
+            Entry entries[4];
+        };
+
+        const Bucket& bucket(uint64_t key) const { return buckets[key & mask]; }
+        Bucket& bucket(uint64_t key) { return buckets[key & mask]; }
+
+        void unmap();
+
+        std::vector<Bucket> memory;
+        Bucket* buckets = nullptr;
+        uint64_t mask = 0;
+
+        void* mapping = nullptr;  // File view when open() succeeded
+        size_t mapping_length = 0;
+    };
+
+    // Perft that skips subtrees already counted through a transposition
+    uint64_t perft(Board& board, int depth, PerftTable& table);
+
+    // Perft of every root move separately, printing each move's node count
+    // and time followed by the total and nodes per second. Comparing the
+    // per-move counts with a reference engine narrows a generator bug down
+    // to one subtree at a time.
+    uint64_t divide(Board& board, int depth, std::ostream& out = std::cout);
+
+    // Run an EPD perft suite, one position per line followed by its expected
+    // counts ("<fen> ;D1 20 ;D2 400 ..."), checking every depth up to
+    // max_depth. Prints pass/fail and nodes per second for each position and
+    // the aggregate NPS; positions with no depth that low are skipped.
+    // Returns true if every count matched and every line parsed. With a table,
+    // counts come from (and go to) it, e.g. a persistent cache from open().
+    bool run_suite(const std::string& path, int max_depth, std::ostream& out = std::cout,
+                   PerftTable* table = nullptr);
+
+    // Per-thread node counter, padded so that counters of different threads
+    // never share a cache line
+    struct alignas(64) Counter {
+        uint64_t nodes = 0ULL;
+    };
+
+    // Perft spread over `threads` threads. The tree is expanded serially for
+    // split_depth plies and each resulting position becomes one task; the
+    // tasks are balanced by work stealing and each thread sums into its own
+    // counter. hash_mb > 0 gives every thread a private PerftTable of
+    // hash_mb / threads megabytes. Returns the same count as MoveGen::perft.
+    uint64_t perft_parallel(const Board& board, int depth, int threads, int split_depth = 2, size_t hash_mb = 0);
+}
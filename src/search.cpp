@@ -0,0 +1,484 @@
+#include "search.h"
+#include "evaluate.h"
+#include "movegen.h"
+#include "movepick.h"
+#include "nnue.h"
+#include "util.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+namespace Search {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Mate scores are stored relative to the node rather than the root, so that
+// an entry reached through a different path still reports the right distance
+int value_to_tt(int v, int ply) {
+    return v >= VALUE_MATE_IN_MAX_PLY ? v + ply : v <= -VALUE_MATE_IN_MAX_PLY ? v - ply : v;
+}
+
+int value_from_tt(int v, int ply) {
+    return v >= VALUE_MATE_IN_MAX_PLY ? v - ply : v <= -VALUE_MATE_IN_MAX_PLY ? v + ply : v;
+}
+
+bool has_non_pawn_material(const Board& board, Color c) {
+    return board.occupied(c) & ~board.pieces(c, PAWN, KING);
+}
+
+// History bonus with gravity: scores saturate at +-16384, which keeps them
+// below the killer scores used by the MovePicker
+void update_history(int& h, int bonus) {
+    h += bonus - h * std::abs(bonus) / 16384;
+}
+
+// Lazy SMP iteration skipping: helper i searches iteration d only when
+// ((d + skip_phase[i]) / skip_size[i]) is even, so the helpers run ahead of
+// and behind the main thread on different depths
+constexpr int SKIP_COUNT = 20;
+constexpr int skip_size[SKIP_COUNT]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+constexpr int skip_phase[SKIP_COUNT] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+class Worker;
+
+// State shared by the threads of one search
+struct Shared {
+    Shared(const Limits& limits, TranspositionTable& tt) : limits(limits), tt(tt) {}
+
+    const Limits& limits;
+    TranspositionTable& tt;
+    std::atomic<bool> stop{false};
+    std::vector<std::unique_ptr<Worker>> workers;
+    Clock::time_point start = Clock::now();
+
+    uint64_t nodes() const;
+    bool pondering() const { return limits.ponder && limits.ponder->load(std::memory_order_relaxed); }
+    double elapsed() const { return std::chrono::duration<double>(Clock::now() - start).count(); }
+};
+
+class Worker {
+public:
+    Worker(int id, const Board& board, Shared& shared, const std::vector<uint64_t>& history)
+        : id(id), board(board), shared(shared), tt(shared.tt), keys(history) {
+        std::memset(killers, 0, sizeof(killers));
+        std::memset(this->history, 0, sizeof(this->history));
+
+        // The copy still points at the caller's accumulator, if any
+        this->board.accumulator = nullptr;
+        if (NNUE::network) {
+            accumulator = std::make_unique<NNUE::Accumulator>();
+            NNUE::attach(this->board, accumulator.get());
+        }
+    }
+
+    Result iterate(std::ostream& out);
+
+    // Written only by the owning thread, read by the main thread for limits
+    // and reporting
+    uint64_t node_count() const { return nodes.load(std::memory_order_relaxed); }
+
+private:
+    int negamax(int alpha, int beta, int depth, int ply, bool null_ok);
+    int qsearch(int alpha, int beta, int ply);
+
+    bool is_draw() const;
+    void count_node();
+    void check_limits();
+
+    int id;
+    Board board;
+    Shared& shared;
+    TranspositionTable& tt;
+
+    // Keys of every position before the current one, game history included
+    std::vector<uint64_t> keys;
+
+    Move killers[MAX_PLY][2];
+    int history[COLOR_NB][64][64];
+
+    Pawns::Table pawns;
+    std::unique_ptr<NNUE::Accumulator> accumulator;
+
+    // Triangular PV table
+    Move pv[MAX_PLY + 1][MAX_PLY + 1];
+    int pv_length[MAX_PLY + 1];
+
+    std::atomic<uint64_t> nodes{0};
+    bool stopped = false;
+    int root_depth = 0;
+};
+
+uint64_t Shared::nodes() const {
+    uint64_t total = 0;
+    for (const auto& w : workers)
+        total += w->node_count();
+    return total;
+}
+
+// Fifty-move rule, or a repetition of any earlier position with the same
+// side to move since the last irreversible move
+bool Worker::is_draw() const {
+    if (board.halfmove_clock >= 100)
+        return true;
+
+    int n = static_cast<int>(keys.size());
+    int end = std::max(0, n - board.halfmove_clock);
+    for (int i = n - 4; i >= end; i -= 2)
+        if (keys[i] == board.key)
+            return true;
+    return false;
+}
+
+void Worker::count_node() {
+    uint64_t n = nodes.load(std::memory_order_relaxed) + 1;
+    nodes.store(n, std::memory_order_relaxed);
+    if ((n & 2047) == 0)
+        check_limits();
+}
+
+// Polled every 2048 nodes. Only the main thread checks the limits, and
+// depth 1 always completes; helpers stop when the main thread does.
+void Worker::check_limits() {
+    if (shared.stop.load(std::memory_order_relaxed)) {
+        stopped = true;
+        return;
+    }
+
+    if (id != 0 || root_depth <= 1)
+        return;
+
+    const Limits& limits = shared.limits;
+    if ((limits.stop && limits.stop->load(std::memory_order_relaxed))
+        || (limits.nodes && shared.nodes() >= limits.nodes)
+        || (limits.movetime_ms && !shared.pondering() && shared.elapsed() * 1000 >= limits.movetime_ms)) {
+        shared.stop = true;
+        stopped = true;
+    }
+}
+
+int Worker::qsearch(int alpha, int beta, int ply) {
+    count_node();
+
+    pv_length[ply] = 0;
+
+    if (ply >= MAX_PLY)
+        return Eval::evaluate(board, pawns);
+
+    MovePicker picker(board, Move::none(), true);
+    bool in_check = picker.check_info().checkers;
+
+    // Stand pat: the side to move can usually do at least as well as the
+    // static evaluation by not capturing. In check every evasion is searched.
+    int best_score = -VALUE_INFINITE;
+    if (!in_check) {
+        best_score = Eval::evaluate(board, pawns);
+        if (best_score >= beta)
+            return best_score;
+        alpha = std::max(alpha, best_score);
+    }
+
+    StateInfo st;
+    Move m;
+    while ((m = picker.next_move()) != Move::none()) {
+        board.make_move(m, st);
+        int score = -qsearch(-beta, -alpha, ply + 1);
+        board.unmake_move(m, st);
+
+        if (stopped)
+            return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta)
+                    break;
+            }
+        }
+    }
+
+    if (in_check && best_score == -VALUE_INFINITE)
+        return -VALUE_MATE + ply;
+
+    return best_score;
+}
+
+int Worker::negamax(int alpha, int beta, int depth, int ply, bool null_ok) {
+    bool root = ply == 0;
+    bool pv_node = beta - alpha > 1;
+
+    if (depth <= 0)
+        return qsearch(alpha, beta, ply);
+
+    count_node();
+
+    pv_length[ply] = 0;
+
+    if (!root) {
+        if (is_draw())
+            return VALUE_DRAW;
+        if (ply >= MAX_PLY)
+            return Eval::evaluate(board, pawns);
+    }
+
+    // Transposition table cutoff, never at PV nodes so the PV stays intact
+    TTEntry tte;
+    bool tt_hit = tt.probe(board.key, tte);
+    Move tt_move = tt_hit ? tte.move : Move::none();
+    if (tt_hit && !pv_node && tte.depth >= depth) {
+        int tt_score = value_from_tt(tte.score, ply);
+        if (tte.bound == BOUND_EXACT
+            || (tte.bound == BOUND_LOWER && tt_score >= beta)
+            || (tte.bound == BOUND_UPPER && tt_score <= alpha))
+            return tt_score;
+    }
+
+    Color us = board.side_to_move;
+    MovePicker picker(board, tt_move, killers[ply], history[us]);
+    bool in_check = picker.check_info().checkers;
+    int eval = in_check ? -VALUE_INFINITE : tt_hit ? tte.eval : Eval::evaluate(board, pawns);
+
+    StateInfo st;
+
+    // Null move pruning: if passing still fails high, a real move will too.
+    // Skipped in check and without pieces, where zugzwang is likely.
+    if (!pv_node && null_ok && !in_check && depth >= 3 && eval >= beta && has_non_pawn_material(board, us)) {
+        int R = 2 + depth / 4;
+
+        keys.push_back(board.key);
+        board.make_null_move(st);
+        int score = -negamax(-beta, -beta + 1, depth - 1 - R, ply + 1, false);
+        board.unmake_null_move(st);
+        keys.pop_back();
+
+        if (stopped)
+            return 0;
+        if (score >= beta)
+            return score >= VALUE_MATE_IN_MAX_PLY ? beta : score;
+    }
+
+    int best_score = -VALUE_INFINITE;
+    Move best_move = Move::none();
+    int move_count = 0;
+
+    Move quiets[64];
+    int quiet_count = 0;
+
+    Move m;
+    while ((m = picker.next_move()) != Move::none()) {
+        bool quiet = !m.is_capture() && !m.is_promotion();
+        move_count++;
+
+        keys.push_back(board.key);
+        board.make_move(m, st);
+
+        int score;
+        if (move_count == 1) {
+            score = -negamax(-beta, -alpha, depth - 1, ply + 1, true);
+        } else {
+            // Late move reductions for quiet moves ordered behind the
+            // hash move, captures and killers
+            int R = 0;
+            if (depth >= 3 && quiet && !in_check && move_count > 3 && m != killers[ply][0] && m != killers[ply][1])
+                R = move_count > 8 ? 2 : 1;
+
+            // Principal variation search: prove the move is no better than
+            // alpha with a null window, re-search only if that fails
+            score = -negamax(-alpha - 1, -alpha, depth - 1 - R, ply + 1, true);
+            if (score > alpha && R > 0)
+                score = -negamax(-alpha - 1, -alpha, depth - 1, ply + 1, true);
+            if (score > alpha && score < beta)
+                score = -negamax(-beta, -alpha, depth - 1, ply + 1, true);
+        }
+
+        board.unmake_move(m, st);
+        keys.pop_back();
+
+        if (stopped)
+            return 0;
+
+        if (score > best_score) {
+            best_score = score;
+
+            if (score > alpha) {
+                alpha = score;
+                best_move = m;
+
+                pv[ply][0] = m;
+                std::copy(pv[ply + 1], pv[ply + 1] + pv_length[ply + 1], pv[ply] + 1);
+                pv_length[ply] = pv_length[ply + 1] + 1;
+
+                if (alpha >= beta)
+                    break;
+            }
+        }
+
+        if (quiet && quiet_count < 64)
+            quiets[quiet_count++] = m;
+    }
+
+    if (move_count == 0)
+        return in_check ? -VALUE_MATE + ply : VALUE_DRAW;
+
+    // A quiet move that caused a cutoff becomes a killer and gains history;
+    // the quiet moves tried before it lose some
+    if (best_score >= beta && !best_move.is_capture() && !best_move.is_promotion()) {
+        if (killers[ply][0] != best_move) {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = best_move;
+        }
+        int bonus = std::min(depth * depth, 400);
+        update_history(history[us][best_move.from()][best_move.to()], bonus);
+        for (int i = 0; i < quiet_count; i++)
+            update_history(history[us][quiets[i].from()][quiets[i].to()], -bonus);
+    }
+
+    Bound bound = best_score >= beta ? BOUND_LOWER : best_move != Move::none() ? BOUND_EXACT : BOUND_UPPER;
+    tt.store(board.key, depth, value_to_tt(best_score, ply), eval, bound, best_move);
+
+    return best_score;
+}
+
+Result Worker::iterate(std::ostream& out) {
+    Result result;
+
+    for (root_depth = 1; root_depth < MAX_PLY; root_depth++) {
+        if (id == 0 && root_depth > shared.limits.depth)
+            break;
+
+        if (id > 0) {
+            int i = (id - 1) % SKIP_COUNT;
+            if (((root_depth + skip_phase[i]) / skip_size[i]) % 2)
+                continue;
+        }
+
+        int score = negamax(-VALUE_INFINITE, VALUE_INFINITE, root_depth, 0, true);
+
+        // An interrupted iteration is discarded
+        if (stopped)
+            break;
+
+        result.depth = root_depth;
+        result.score = score;
+        result.pv.assign(pv[0], pv[0] + pv_length[0]);
+        if (!result.pv.empty())
+            result.best_move = result.pv[0];
+
+        if (id == 0) {
+            uint64_t total = shared.nodes();
+            double seconds = shared.elapsed();
+
+            // Built up front and written at once, so the line cannot be split
+            // by output from another thread
+            std::ostringstream info;
+            info << "info depth " << root_depth << " score ";
+            if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY)
+                info << "mate " << (score > 0 ? (VALUE_MATE - score + 1) / 2 : -(VALUE_MATE + score) / 2);
+            else
+                info << "cp " << score;
+            info << " nodes " << total
+                 << " nps " << static_cast<uint64_t>(seconds > 0 ? total / seconds : 0)
+                 << " hashfull " << tt.hashfull()
+                 << " time " << static_cast<int64_t>(seconds * 1000) << " pv";
+            for (const Move& m : result.pv)
+                info << " " << move_to_string(m);
+            info << "\n";
+            out << info.str() << std::flush;
+
+            // Another iteration would most likely not finish in time
+            const Limits& limits = shared.limits;
+            if (limits.optimum_ms && !shared.pondering() && seconds * 1000 >= limits.optimum_ms)
+                break;
+        }
+
+        // No point searching deeper once a mate has been found
+        if (std::abs(score) >= VALUE_MATE_IN_MAX_PLY && VALUE_MATE - std::abs(score) <= root_depth)
+            break;
+    }
+
+    // The main thread finishing ends the search for the helpers
+    if (id == 0)
+        shared.stop = true;
+
+    return result;
+}
+
+} // namespace
+
+const std::vector<std::string> bench_positions = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bq1rk1/pp2bppp/2n1pn2/2pp4/3P4/2PBPN2/PP1N1PPP/R1BQ1RK1 w - - 0 8",
+    "r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bqkb1r/pp3ppp/2np1n2/4p3/2B1P3/2N2N2/PPP2PPP/R1BQK2R w KQkq - 0 7",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "8/8/1p1k4/p1pP4/P1P3K1/8/8/8 w - - 0 1",
+};
+
+Result search(const Board& board, const Limits& limits, TranspositionTable& tt, int threads,
+              const std::vector<uint64_t>& history, std::ostream& out) {
+    tt.new_search();
+
+    Shared shared(limits, tt);
+    for (int i = 0; i < std::max(threads, 1); i++)
+        shared.workers.push_back(std::make_unique<Worker>(i, board, shared, history));
+
+    std::vector<std::thread> helpers;
+    for (size_t i = 1; i < shared.workers.size(); i++)
+        helpers.emplace_back([&shared, &out, i] { shared.workers[i]->iterate(out); });
+
+    Result result = shared.workers[0]->iterate(out);
+
+    for (std::thread& t : helpers)
+        t.join();
+
+    result.nodes = shared.nodes();
+    result.seconds = shared.elapsed();
+    return result;
+}
+
+void time_to_depth(const std::vector<std::string>& fens, int depth, const std::vector<int>& thread_counts,
+                   size_t hash_mb, std::ostream& out) {
+    TranspositionTable tt(hash_mb);
+    Limits limits;
+    limits.depth = depth;
+
+    double base = 0.0;
+    for (int threads : thread_counts) {
+        double seconds = 0.0;
+        uint64_t nodes = 0;
+
+        for (const std::string& fen : fens) {
+            Board board;
+            if (!board.set_fen(fen))
+                continue;
+
+            tt.clear();
+            std::ostringstream info;
+            Result r = search(board, limits, tt, threads, {}, info);
+            seconds += r.seconds;
+            nodes += r.nodes;
+        }
+
+        if (base == 0.0)
+            base = seconds;
+
+        out << "Threads: " << threads
+            << "  Time: " << seconds << "s"
+            << "  Nodes: " << nodes
+            << "  NPS: " << static_cast<uint64_t>(seconds > 0 ? nodes / seconds : 0)
+            << "  Speedup: " << (seconds > 0 ? base / seconds : 0.0) << "\n";
+    }
+}
+
+}
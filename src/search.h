@@ -0,0 +1,68 @@
+#pragma once
+
+#include "board.h"
+#include "tt.h"
+#include "types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace Search {
+    constexpr int MAX_PLY = 128;
+
+    // Scores are in centipawns from the side to move's point of view. Mate in
+    // n plies scores VALUE_MATE - n, so anything beyond VALUE_MATE_IN_MAX_PLY
+    // is a forced mate.
+    constexpr int VALUE_DRAW = 0;
+    constexpr int VALUE_MATE = 32000;
+    constexpr int VALUE_INFINITE = 32001;
+    constexpr int VALUE_MATE_IN_MAX_PLY = VALUE_MATE - MAX_PLY;
+
+    // When to stop. A zero nodes, movetime_ms or optimum_ms means no limit.
+    // movetime_ms is a hard limit; past optimum_ms no new iteration is
+    // started. The search also stops as soon as *stop becomes true, but never
+    // before depth 1 has been completed, so there is always a move to play.
+    // While *ponder is true the time limits are ignored.
+    struct Limits {
+        int depth = MAX_PLY - 1;
+        uint64_t nodes = 0;
+        int64_t movetime_ms = 0;
+        int64_t optimum_ms = 0;
+        const std::atomic<bool>* stop = nullptr;
+        const std::atomic<bool>* ponder = nullptr;
+    };
+
+    struct Result {
+        Move best_move = Move::none();
+        int score = 0;
+        int depth = 0;         // Last fully completed iteration
+        uint64_t nodes = 0;
+        double seconds = 0.0;
+        std::vector<Move> pv;
+    };
+
+    // Iterative deepening alpha-beta search from `board`. `history` holds the
+    // keys of the game positions before it, oldest first, for repetition
+    // detection. One UCI-style "info" line is written to `out` per completed
+    // depth.
+    //
+    // With threads > 1 the search runs Lazy SMP: every thread searches the
+    // same root with its own Board copy, killers and history, helpers skip
+    // some iterations so the threads spread over different depths, and all
+    // of them share `tt`. The result and the info lines come from the main
+    // thread; node counts are summed over all threads.
+    Result search(const Board& board, const Limits& limits, TranspositionTable& tt, int threads = 1,
+                  const std::vector<uint64_t>& history = {}, std::ostream& out = std::cout);
+
+    // Time-to-depth scaling: search every position in `fens` to `depth` with
+    // each thread count in turn, on a freshly cleared hash of hash_mb, and
+    // print the total time, nodes and speedup over the first thread count.
+    void time_to_depth(const std::vector<std::string>& fens, int depth, const std::vector<int>& thread_counts,
+                       size_t hash_mb, std::ostream& out = std::cout);
+
+    // Fixed middlegame and endgame positions for time_to_depth and benchmarks
+    extern const std::vector<std::string> bench_positions;
+}
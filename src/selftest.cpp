@@ -0,0 +1,296 @@
+#include "selftest.h"
+#include "batch.h"
+#include "board.h"
+#include "book.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "packed.h"
+#include "perft.h"
+#include "search.h"
+#include "util.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace SelfTest {
+
+namespace {
+
+struct Context {
+    std::ostream& out;
+    int passed = 0;
+    int failed = 0;
+
+    void check(bool ok, const std::string& what) {
+        if (ok) {
+            passed++;
+        } else {
+            failed++;
+            out << "FAIL  " << what << "\n";
+        }
+    }
+};
+
+std::string hex(uint64_t x) {
+    char buf[24];
+    std::snprintf(buf, sizeof buf, "%016llx", static_cast<unsigned long long>(x));
+    return buf;
+}
+
+// Play UCI moves on board; false if one of them is not legal
+bool play(Board& board, const std::vector<std::string>& moves) {
+    for (const std::string& str : moves) {
+        MoveList legal;
+        MoveGen::generate_legal_moves(board, legal);
+        bool found = false;
+        for (const Move& m : legal) {
+            if (move_to_string(m) == str) {
+                board.make_move(m);
+                found = true;
+                break;
+            }
+        }
+        if (!found)
+            return false;
+    }
+    return true;
+}
+
+// The worked examples of the Polyglot specification, covering castling
+// rights lost by king moves and en passant files with and without a
+// capturing pawn. Each position is reached both from its FEN and by
+// playing the moves, so the keys of make_move's state count too.
+void polyglot_keys(Context& ctx) {
+    struct Example {
+        std::vector<std::string> moves;
+        const char* fen;
+        uint64_t key;
+    };
+    const Example examples[] = {
+        {{}, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0x463b96181691fc9cULL},
+        {{"e2e4"}, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", 0x823c9b50fd114196ULL},
+        {{"e2e4", "d7d5"}, "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", 0x0756b94461c50fb0ULL},
+        {{"e2e4", "d7d5", "e4e5"}, "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", 0x662fafb965db29d4ULL},
+        {{"e2e4", "d7d5", "e4e5", "f7f5"}, "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+         0x22a48b5a8e47ff78ULL},
+        {{"e2e4", "d7d5", "e4e5", "f7f5", "e1e2"}, "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3",
+         0x652a607ca3f242c1ULL},
+        {{"e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7"}, "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4",
+         0x00fdd303c946bdd9ULL},
+        {{"a2a4", "b7b5", "h2h4", "b5b4", "c2c4"}, "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3",
+         0x3c8123ea7b067637ULL},
+        {{"a2a4", "b7b5", "h2h4", "b5b4", "c2c4", "b4c3", "a1a3"},
+         "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", 0x5c3f9b829b279560ULL},
+    };
+
+    for (const Example& e : examples) {
+        Board from_fen;
+        bool parsed = from_fen.set_fen(e.fen);
+        ctx.check(parsed, std::string("Polyglot example FEN parses: ") + e.fen);
+        if (parsed)
+            ctx.check(Book::key(from_fen) == e.key, std::string("Polyglot key of ") + e.fen + ": got "
+                      + hex(Book::key(from_fen)) + ", expected " + hex(e.key));
+
+        Board played;
+        bool legal = play(played, e.moves);
+        ctx.check(legal, std::string("Polyglot example moves are legal: ") + e.fen);
+        if (legal)
+            ctx.check(Book::key(played) == e.key, std::string("Polyglot key after the moves to ") + e.fen
+                      + ": got " + hex(Book::key(played)) + ", expected " + hex(e.key));
+    }
+}
+
+// Work-stealing perft against serial perft on the standard positions, over
+// several thread counts and split depths, with and without hash tables
+void parallel_perft(Context& ctx) {
+    struct Position {
+        const char* fen;
+        int depth;
+    };
+    const Position positions[] = {
+        {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4},
+        {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4},
+        {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5},
+        {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4},
+        {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4},
+        {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4},
+    };
+
+    for (const Position& p : positions) {
+        Board board;
+        if (!board.set_fen(p.fen)) {
+            ctx.check(false, std::string("perft position parses: ") + p.fen);
+            continue;
+        }
+        Board serial_board = board;
+        uint64_t serial = MoveGen::perft(serial_board, p.depth);
+
+        for (int threads : {1, 2, 3, 8}) {
+            for (int split : {1, 2}) {
+                for (size_t hash_mb : {size_t(0), size_t(8)}) {
+                    uint64_t nodes = Perft::perft_parallel(board, p.depth, threads, split, hash_mb);
+                    ctx.check(nodes == serial, std::string("perft_parallel of ") + p.fen + " depth "
+                              + std::to_string(p.depth) + ", " + std::to_string(threads) + " threads, split "
+                              + std::to_string(split) + ", hash " + std::to_string(hash_mb) + " MB: got "
+                              + std::to_string(nodes) + ", expected " + std::to_string(serial));
+                }
+            }
+        }
+    }
+}
+
+// Batch analysis on every backend this CPU runs against the per-position
+// move generator, over the bench positions and all their children
+void batch_analysis(Context& ctx) {
+    std::vector<Board> boards;
+    for (const std::string& fen : Search::bench_positions) {
+        Board board;
+        if (!board.set_fen(fen))
+            continue;
+        boards.push_back(board);
+
+        MoveList moves;
+        MoveGen::generate_legal_moves(board, moves);
+        for (const Move& m : moves) {
+            Board child = board;
+            child.make_move(m);
+            boards.push_back(child);
+        }
+    }
+
+    Batch::Positions positions;
+    for (const Board& board : boards)
+        positions.push_back(board);
+
+    for (Batch::Backend backend : {Batch::SCALAR, Batch::AVX2, Batch::AVX512}) {
+        if (backend > Batch::best_backend())
+            continue;
+
+        Batch::Results results;
+        Batch::analyze(positions, results, backend);
+        std::string name = Batch::backend_name(backend);
+
+        for (size_t i = 0; i < boards.size(); i++) {
+            const Board& board = boards[i];
+            MoveGen::CheckInfo info = MoveGen::compute_check_info(board);
+            std::string where = " (" + name + ") of " + board.fen();
+
+            ctx.check(results.legal_moves[i] == MoveGen::count_legal_moves(board), "legal moves" + where);
+            ctx.check(results.checkers[i] == info.checkers, "checkers" + where);
+            ctx.check(results.pinned[i] == info.pinned, "pinned" + where);
+            for (Color c : {WHITE, BLACK})
+                ctx.check(results.attacks[c][i] == MoveGen::attacked_squares(board, c, board.occupied()),
+                          std::string(c == WHITE ? "white" : "black") + " attacks" + where);
+        }
+    }
+}
+
+// Records that pack cannot produce are rejected and leave the board as it was
+void packed_rejects(Context& ctx) {
+    Board source;
+    Packed::PackedPosition valid;
+    source.set_fen("r3k2r/ppp1pppp/8/3pP3/8/8/PPPP1PPP/R3K2R w KQkq d6 0 3");
+    if (!Packed::pack(source, valid)) {
+        ctx.check(false, "pack of the unpack test position");
+        return;
+    }
+
+    Board board;
+    ctx.check(Packed::unpack(valid, board) && board.fen() == source.fen(), "unpack of a valid record");
+
+    // The valid record with one change, unpacked onto a start position
+    auto corrupt = [&](const char* what, auto change) {
+        Packed::PackedPosition record = valid;
+        change(record);
+        Board before;
+        Board target = before;
+        ctx.check(!Packed::unpack(record, target), std::string("unpack rejects ") + what);
+        ctx.check(target.fen() == before.fen() && target.key == before.key,
+                  std::string("board unchanged after ") + what);
+    };
+    // Replace the piece on an occupied square
+    auto set_nibble = [&](Packed::PackedPosition& record, int sq, uint8_t nibble) {
+        int n = Bitboards::popcount(record.occupied & ((1ULL << sq) - 1));
+        uint8_t& byte = record.pieces[n / 2];
+        byte = (n % 2) ? static_cast<uint8_t>((byte & 0x0F) | nibble << 4) : static_cast<uint8_t>((byte & 0xF0) | nibble);
+    };
+
+    corrupt("a pawn on the last rank", [&](Packed::PackedPosition& r) { set_nibble(r, 63, BLACK << 3 | PAWN); });
+    corrupt("a pawn on the first rank", [&](Packed::PackedPosition& r) { set_nibble(r, 0, WHITE << 3 | PAWN); });
+    corrupt("a castling right without its rook", [&](Packed::PackedPosition& r) { set_nibble(r, 7, WHITE << 3 | KNIGHT); });
+    corrupt("a castling right without its king", [&](Packed::PackedPosition& r) {
+        set_nibble(r, 56, BLACK << 3 | KING);
+        set_nibble(r, 60, BLACK << 3 | QUEEN);
+    });
+    corrupt("an en passant square on the wrong rank", [&](Packed::PackedPosition& r) { r.en_passant = 19; });
+    corrupt("an en passant square without a pawn", [&](Packed::PackedPosition& r) { r.en_passant = 44; });
+    corrupt("an en passant square off the board", [&](Packed::PackedPosition& r) { r.en_passant = 64; });
+    corrupt("unknown flag bits", [&](Packed::PackedPosition& r) { r.flags |= 0x10; });
+    corrupt("a third king", [&](Packed::PackedPosition& r) { set_nibble(r, 8, WHITE << 3 | KING); });
+}
+
+// Network evaluation of a board unpacked into one that already has an
+// accumulator attached, and after a move on top of it, against the same
+// positions computed from scratch. unpack puts the pieces before the kings
+// they are seen from, so the accumulator must be rebuilt, not updated.
+void nnue_unpack(Context& ctx) {
+    bool random = !NNUE::network;
+    if (random)
+        NNUE::randomize(1);
+
+    NNUE::Accumulator acc;
+    Board board;
+    NNUE::attach(board, &acc);
+    NNUE::evaluate(board);
+
+    auto full = [](const Board& b) {
+        Board copy = b;
+        copy.accumulator = nullptr;
+        return NNUE::evaluate(copy);
+    };
+
+    for (const std::string& fen : Search::bench_positions) {
+        Board source;
+        Packed::PackedPosition record;
+        if (!source.set_fen(fen) || !Packed::pack(source, record))
+            continue;
+
+        bool unpacked = Packed::unpack(record, board);
+        ctx.check(unpacked, "unpack of " + fen);
+        if (!unpacked)
+            continue;
+        ctx.check(NNUE::evaluate(board) == full(board), "NNUE eval after unpack of " + fen);
+
+        MoveList moves;
+        MoveGen::generate_legal_moves(board, moves);
+        for (const Move& m : moves) {
+            StateInfo st;
+            board.make_move(m, st);
+            ctx.check(NNUE::evaluate(board) == full(board),
+                      "NNUE eval after unpack of " + fen + " and " + move_to_string(m));
+            board.unmake_move(m, st);
+        }
+    }
+
+    if (random)
+        NNUE::unload();
+}
+
+} // namespace
+
+bool run(std::ostream& out) {
+    Context ctx{out};
+
+    parallel_perft(ctx);
+    polyglot_keys(ctx);
+    batch_analysis(ctx);
+    packed_rejects(ctx);
+    nnue_unpack(ctx);
+
+    out << ctx.passed << " passed, " << ctx.failed << " failed\n";
+    return ctx.failed == 0;
+}
+
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <iostream>
+
+// Known-answer checks for what the perft suite does not reach: parallel
+// perft against serial perft, Polyglot keys against the examples of the
+// specification, each batch backend against the move generator, rejection
+// of corrupt packed records, and network evaluation of unpacked positions
+// against a full recomputation.
+// Each failed check prints a line; the summary goes last.
+namespace SelfTest {
+    // Run every check; returns true if all passed
+    bool run(std::ostream& out = std::cout);
+}
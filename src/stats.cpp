@@ -0,0 +1,109 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace Stats {
+
+namespace {
+
+std::mutex registry_mutex;
+std::vector<ThreadStats*> live;  // Blocks of running threads
+ThreadStats retired{};           // Sum of the blocks of exited threads
+
+void accumulate(ThreadStats& sum, const ThreadStats& s) {
+    for (int i = 0; i < COUNTER_NB; i++)
+        sum.counters[i] += s.counters[i];
+    for (int i = 0; i < TIMER_NB; i++) {
+        sum.cycles[i] += s.cycles[i];
+        sum.calls[i] += s.calls[i];
+    }
+}
+
+#ifdef USE_STATS
+const char* counter_names[COUNTER_NB] = {
+    "generate_pawn_moves", "generate_knight_moves", "generate_bishop_moves",
+    "generate_rook_moves", "generate_queen_moves", "generate_king_moves",
+    "generate_castling_moves", "make_move", "unmake_move", "is_square_attacked",
+    "pseudo-legal moves", "legal moves"
+};
+
+const char* timer_names[TIMER_NB] = {
+    "check info", "generate", "count moves", "make move", "unmake move"
+};
+
+// Time stamp ticks per nanosecond, measured against the steady clock
+double ticks_per_ns() {
+    using Clock = std::chrono::steady_clock;
+    auto start = Clock::now();
+    uint64_t t0 = timestamp();
+    while (Clock::now() - start < std::chrono::milliseconds(20)) {}
+    uint64_t t1 = timestamp();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return ns > 0 ? (t1 - t0) / ns : 1.0;
+}
+#endif
+
+} // namespace
+
+Slot::Slot() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    live.push_back(&stats);
+}
+
+Slot::~Slot() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    accumulate(retired, stats);
+    live.erase(std::find(live.begin(), live.end(), &stats));
+}
+
+ThreadStats total() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    ThreadStats sum = retired;
+    for (const ThreadStats* s : live)
+        accumulate(sum, *s);
+    return sum;
+}
+
+void reset() {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    retired = ThreadStats{};
+    for (ThreadStats* s : live)
+        *s = ThreadStats{};
+}
+
+void print([[maybe_unused]] std::ostream& out) {
+#ifdef USE_STATS
+    ThreadStats sum = total();
+    char line[128];
+
+    out << "\nCounters\n";
+    for (int i = 0; i < COUNTER_NB; i++) {
+        std::snprintf(line, sizeof line, "  %-26s %16llu\n", counter_names[i],
+                      static_cast<unsigned long long>(sum.counters[i]));
+        out << line;
+    }
+    if (sum.counters[PSEUDO_LEGAL_MOVES]) {
+        std::snprintf(line, sizeof line, "  %-26s %15.2f%%\n", "legal / pseudo-legal",
+                      100.0 * sum.counters[LEGAL_MOVES] / sum.counters[PSEUDO_LEGAL_MOVES]);
+        out << line;
+    }
+
+    double tpn = ticks_per_ns();
+    std::snprintf(line, sizeof line, "\n%-28s %14s %14s %10s %10s\n",
+                  "Stages (inclusive)", "calls", "ticks", "ticks/call", "ns/call");
+    out << line;
+    for (int i = 0; i < TIMER_NB; i++) {
+        double per_call = sum.calls[i] ? double(sum.cycles[i]) / sum.calls[i] : 0.0;
+        std::snprintf(line, sizeof line, "  %-26s %14llu %14llu %10.1f %10.1f\n", timer_names[i],
+                      static_cast<unsigned long long>(sum.calls[i]),
+                      static_cast<unsigned long long>(sum.cycles[i]), per_call, per_call / tpn);
+        out << line;
+    }
+#endif
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+
+#ifdef USE_STATS
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+// Hot-path instrumentation, compiled in with `make STATS=1` (-DUSE_STATS).
+// Every thread counts into its own cache-line aligned block, so counting
+// never shares a line between threads; the blocks are summed when the
+// report is printed. Without USE_STATS the macros below expand to nothing
+// and their arguments are not evaluated.
+namespace Stats {
+#ifdef USE_STATS
+    constexpr bool enabled = true;
+#else
+    constexpr bool enabled = false;
+#endif
+
+    enum Counter {
+        GEN_PAWN, GEN_KNIGHT, GEN_BISHOP, GEN_ROOK, GEN_QUEEN, GEN_KING, GEN_CASTLING,
+        MAKE_MOVE, UNMAKE_MOVE, SQUARE_ATTACKED,
+        PSEUDO_LEGAL_MOVES,  // Moves a pseudo-legal generator would have produced
+        LEGAL_MOVES,         // Moves actually generated or counted
+        COUNTER_NB
+    };
+
+    // Stages timed with the time stamp counter. Times are inclusive: the
+    // check info computed inside count_legal_moves is in both stages.
+    enum Timer {
+        CHECK_INFO, GENERATE, COUNT_MOVES, DO_MOVE, UNDO_MOVE,
+        TIMER_NB
+    };
+
+    struct alignas(64) ThreadStats {
+        uint64_t counters[COUNTER_NB];
+        uint64_t cycles[TIMER_NB];
+        uint64_t calls[TIMER_NB];
+    };
+
+    // A thread's block registers itself on first use. When the thread exits
+    // its counts are folded into a shared total, so nothing is lost once
+    // worker threads have been joined.
+    struct Slot {
+        ThreadStats stats{};
+        Slot();
+        ~Slot();
+    };
+
+    inline ThreadStats& local() {
+        thread_local Slot slot;
+        return slot.stats;
+    }
+
+    // Sum over all threads, live and exited. Reading the live blocks is only
+    // exact when no other thread is counting at the same time.
+    ThreadStats total();
+    void reset();
+
+    // Counter and stage table of total(); does nothing without USE_STATS
+    void print(std::ostream& out = std::cerr);
+
+#ifdef USE_STATS
+    inline uint64_t timestamp() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+    }
+
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Timer t) : timer(t), start(timestamp()) {}
+        ~ScopedTimer() {
+            ThreadStats& s = local();
+            s.cycles[timer] += timestamp() - start;
+            s.calls[timer]++;
+        }
+
+    private:
+        Timer timer;
+        uint64_t start;
+    };
+#endif
+}
+
+#ifdef USE_STATS
+#define STATS_INC(c)     (Stats::local().counters[Stats::c]++)
+#define STATS_ADD(c, n)  (Stats::local().counters[Stats::c] += (n))
+#define STATS_TIME(t)    Stats::ScopedTimer stats_timer_##t(Stats::t)
+#else
+#define STATS_INC(c)     ((void)0)
+#define STATS_ADD(c, n)  ((void)0)
+#define STATS_TIME(t)    ((void)0)
+#endif
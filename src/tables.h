@@ -0,0 +1,96 @@
+#pragma once
+
+#include "types.h"
+
+#include <array>
+
+// Leaper, pawn and line lookup tables, generated by the compiler so they
+// cost nothing at startup. Slider tables live in magic.h.
+namespace MoveGen {
+    namespace detail {
+        constexpr Bitboard NOT_FILE_A  = 0xFEFEFEFEFEFEFEFEULL;
+        constexpr Bitboard NOT_FILE_H  = 0x7F7F7F7F7F7F7F7FULL;
+        constexpr Bitboard NOT_FILE_AB = 0xFCFCFCFCFCFCFCFCULL;
+        constexpr Bitboard NOT_FILE_GH = 0x3F3F3F3F3F3F3F3FULL;
+
+        using SquareTable = std::array<Bitboard, 64>;
+        using PairTable = std::array<std::array<Bitboard, 64>, 64>;
+
+        constexpr SquareTable make_knight_attacks() {
+            SquareTable table{};
+            for (int sq = 0; sq < 64; sq++) {
+                Bitboard bit = 1ULL << sq;
+                table[sq] = ((bit << 17) & NOT_FILE_A)  | ((bit << 15) & NOT_FILE_H)
+                          | ((bit << 10) & NOT_FILE_AB) | ((bit << 6)  & NOT_FILE_GH)
+                          | ((bit >> 17) & NOT_FILE_H)  | ((bit >> 15) & NOT_FILE_A)
+                          | ((bit >> 10) & NOT_FILE_GH) | ((bit >> 6)  & NOT_FILE_AB);
+            }
+            return table;
+        }
+
+        constexpr SquareTable make_king_attacks() {
+            SquareTable table{};
+            for (int sq = 0; sq < 64; sq++) {
+                Bitboard bit = 1ULL << sq;
+                table[sq] = (bit << 8) | (bit >> 8)
+                          | ((bit << 1) & NOT_FILE_A) | ((bit >> 1) & NOT_FILE_H)
+                          | ((bit << 9) & NOT_FILE_A) | ((bit << 7) & NOT_FILE_H)
+                          | ((bit >> 7) & NOT_FILE_A) | ((bit >> 9) & NOT_FILE_H);
+            }
+            return table;
+        }
+
+        constexpr std::array<SquareTable, COLOR_NB> make_pawn_attacks() {
+            std::array<SquareTable, COLOR_NB> table{};
+            for (int sq = 0; sq < 64; sq++) {
+                Bitboard bit = 1ULL << sq;
+                table[WHITE][sq] = ((bit << 7) & NOT_FILE_H) | ((bit << 9) & NOT_FILE_A);
+                table[BLACK][sq] = ((bit >> 7) & NOT_FILE_A) | ((bit >> 9) & NOT_FILE_H);
+            }
+            return table;
+        }
+
+        // Squares strictly between two aligned squares or, with full_line, the
+        // whole line through them edge to edge. Empty if not aligned.
+        constexpr PairTable make_line_table(bool full_line) {
+            PairTable table{};
+            for (int a = 0; a < 64; a++) {
+                for (int b = 0; b < 64; b++) {
+                    int dr = b / 8 - a / 8, df = b % 8 - a % 8;
+                    if (a == b || !(dr == 0 || df == 0 || dr == df || dr == -df))
+                        continue;
+
+                    int step_r = (dr > 0) - (dr < 0), step_f = (df > 0) - (df < 0);
+                    Bitboard bb = 0ULL;
+
+                    if (full_line) {
+                        // Back up to the board edge, then walk to the other edge
+                        int r = a / 8, f = a % 8;
+                        while (r - step_r >= 0 && r - step_r <= 7 && f - step_f >= 0 && f - step_f <= 7) {
+                            r -= step_r;
+                            f -= step_f;
+                        }
+                        for (; r >= 0 && r <= 7 && f >= 0 && f <= 7; r += step_r, f += step_f)
+                            bb |= 1ULL << (r * 8 + f);
+                    } else {
+                        for (int r = a / 8 + step_r, f = a % 8 + step_f; r * 8 + f != b; r += step_r, f += step_f)
+                            bb |= 1ULL << (r * 8 + f);
+                    }
+
+                    table[a][b] = bb;
+                }
+            }
+            return table;
+        }
+    }
+
+    inline constexpr detail::SquareTable knight_attacks = detail::make_knight_attacks();
+    inline constexpr detail::SquareTable king_attacks = detail::make_king_attacks();
+
+    // pawn_attacks[c][sq]: squares a pawn of color c on sq attacks
+    inline constexpr std::array<detail::SquareTable, COLOR_NB> pawn_attacks = detail::make_pawn_attacks();
+
+    // Squares strictly between / on the whole line through two aligned squares
+    inline constexpr detail::PairTable between_bb = detail::make_line_table(false);
+    inline constexpr detail::PairTable line_bb = detail::make_line_table(true);
+}
@@ -0,0 +1,100 @@
+#include "tt.h"
+
+namespace Search {
+
+TranspositionTable::TranspositionTable(size_t megabytes) {
+    resize(megabytes);
+}
+
+void TranspositionTable::resize(size_t megabytes) {
+    size_t n = 1;
+    while (n * 2 * sizeof(Bucket) <= megabytes * 1024 * 1024)
+        n *= 2;
+
+    buckets = std::make_unique<Bucket[]>(n);
+    count = n;
+    mask = n - 1;
+    clear();
+}
+
+void TranspositionTable::clear() {
+    for (size_t i = 0; i < count; i++) {
+        for (Slot& s : buckets[i].slots) {
+            s.key.store(0, std::memory_order_relaxed);
+            s.data.store(0, std::memory_order_relaxed);
+        }
+    }
+    generation = 0;
+}
+
+TTEntry TranspositionTable::unpack(uint64_t data) {
+    TTEntry e;
+    e.move.data = static_cast<uint16_t>(data);
+    e.score = static_cast<int16_t>(data >> 16);
+    e.eval = static_cast<int16_t>(data >> 32);
+    e.depth = static_cast<int8_t>(data >> 48);
+    e.bound = static_cast<Bound>((data >> 56) & 0x3);
+    e.generation = static_cast<uint8_t>(data >> 58);
+    return e;
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry& entry) const {
+    for (const Slot& s : buckets[key & mask].slots) {
+        uint64_t data = s.data.load(std::memory_order_relaxed);
+        if ((s.key.load(std::memory_order_relaxed) ^ data) == key && data) {
+            entry = unpack(data);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::store(uint64_t key, int depth, int score, int eval, Bound bound, Move move) {
+    Bucket& bucket = buckets[key & mask];
+
+    // Same position: overwrite in place. Otherwise replace the least valuable
+    // entry, where every search of age counts as 8 plies of depth.
+    Slot* replace = &bucket.slots[0];
+    int replace_value = 0;
+    for (Slot& s : bucket.slots) {
+        uint64_t data = s.data.load(std::memory_order_relaxed);
+        TTEntry e = unpack(data);
+
+        if ((s.key.load(std::memory_order_relaxed) ^ data) == key) {
+            replace = &s;
+            // Keep the old move if the new result has none
+            if (move == Move::none())
+                move = e.move;
+            break;
+        }
+
+        int value = e.depth - 8 * ((generation - e.generation) & 0x3F);
+        if (&s == &bucket.slots[0] || value < replace_value) {
+            replace = &s;
+            replace_value = value;
+        }
+    }
+
+    uint64_t data = static_cast<uint64_t>(move.data)
+                  | static_cast<uint64_t>(static_cast<uint16_t>(score)) << 16
+                  | static_cast<uint64_t>(static_cast<uint16_t>(eval)) << 32
+                  | static_cast<uint64_t>(static_cast<uint8_t>(depth)) << 48
+                  | static_cast<uint64_t>(bound) << 56
+                  | static_cast<uint64_t>(generation) << 58;
+
+    replace->key.store(key ^ data, std::memory_order_relaxed);
+    replace->data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::hashfull() const {
+    int used = 0;
+    for (size_t i = 0; i < 250 && i < count; i++) {
+        for (const Slot& s : buckets[i].slots) {
+            TTEntry e = unpack(s.data.load(std::memory_order_relaxed));
+            used += e.bound != BOUND_NONE && e.generation == generation;
+        }
+    }
+    return used;
+}
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "types.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace Search {
+    enum Bound : uint8_t {
+        BOUND_NONE,
+        BOUND_UPPER,  // Fail-low: the true score is at most the stored one
+        BOUND_LOWER,  // Fail-high: the true score is at least the stored one
+        BOUND_EXACT
+    };
+
+    // Decoded table entry, as returned by probe
+    struct TTEntry {
+        Move move;
+        int16_t score;
+        int16_t eval;
+        int8_t depth;
+        Bound bound;
+        uint8_t generation;
+    };
+
+    // Search transposition table, shared by all search threads without locks.
+    // Same layout as Perft::PerftTable: a power-of-two array of 64-byte
+    // buckets with four 16-byte slots each. A slot holds the entry packed
+    // into one 64-bit data word and the Zobrist key XORed with that word.
+    // A write racing with another thread can tear a slot, but then the key
+    // check fails and the probe misses instead of returning a mixed entry.
+    // On a miss the slot with the lowest depth, counting older searches as
+    // shallower, is replaced.
+    class TranspositionTable {
+    public:
+        explicit TranspositionTable(size_t megabytes);
+
+        // Not thread-safe: only call while no search is running
+        void resize(size_t megabytes);
+        void clear();
+
+        // Call once per search so entries from earlier searches age out
+        void new_search() { generation = (generation + 1) & 0x3F; }
+
+        bool probe(uint64_t key, TTEntry& entry) const;
+        void store(uint64_t key, int depth, int score, int eval, Bound bound, Move move);
+
+        // Permille of sampled entries written by the current search
+        int hashfull() const;
+
+    private:
+        // data: move (bits 0-15), score (16-31), eval (32-47), depth (48-55),
+        // bound (56-57), generation (58-63)
+        struct Slot {
+            std::atomic<uint64_t> key;
+            std::atomic<uint64_t> data;
+        };
+
+        struct alignas(64) Bucket {
+            Slot slots[4];
+        };
+
+        static TTEntry unpack(uint64_t data);
+
+        std::unique_ptr<Bucket[]> buckets;
+        size_t count = 0;
+        uint64_t mask = 0;
+        uint8_t generation = 0;
+    };
+}
@@ -6,14 +6,83 @@ using Bitboard = uint64_t;
 
 enum Piece {
     NO_PIECE,
+    ALL_PIECES = NO_PIECE,  // Board::by_type index of the total occupancy
     PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING,
     PIECE_NB
 };
 
+// Pawn to king, for arrays that have no use for a NO_PIECE slot
+constexpr int PIECE_TYPE_NB = PIECE_NB - PAWN;
+
+// Special-move flags stored in the top 4 bits of a Move. Bit 2 marks
+// captures and bit 3 promotions; for promotions the low two bits give the
+// piece (KNIGHT + n).
+enum MoveFlag {
+    QUIET         = 0,
+    DOUBLE_PUSH   = 1,
+    KING_CASTLE   = 2,
+    QUEEN_CASTLE  = 3,
+    CAPTURE       = 4,
+    EN_PASSANT    = 5,
+    PROMOTION     = 8,
+    PROMO_CAPTURE = 12
+};
+
+// Packed 16-bit move: from (bits 0-5), to (bits 6-11), flags (bits 12-15)
 struct Move {
-    int from;
-    int to;
-    Piece promotion;  // NO_PIECE if not promotion
+    uint16_t data;
+
+    Move() = default;
+    constexpr Move(int from, int to, int flags = QUIET)
+        : data(static_cast<uint16_t>(from | (to << 6) | (flags << 12))) {}
+
+    // Promotion to `piece`, optionally capturing
+    static constexpr Move promotion_to(int from, int to, Piece piece, bool capture) {
+        return Move(from, to, (capture ? PROMO_CAPTURE : PROMOTION) | (piece - KNIGHT));
+    }
+
+    // The all-zero move (a1a1), used as "no move"
+    static constexpr Move none() { return Move(0, 0); }
+
+    constexpr int from() const { return data & 0x3F; }
+    constexpr int to() const { return (data >> 6) & 0x3F; }
+    constexpr int flags() const { return data >> 12; }
+
+    constexpr bool is_capture() const { return flags() & CAPTURE; }
+    constexpr bool is_promotion() const { return flags() & PROMOTION; }
+    constexpr bool is_castling() const { return flags() == KING_CASTLE || flags() == QUEEN_CASTLE; }
+
+    // Promoted piece, NO_PIECE if not a promotion
+    constexpr Piece promotion() const {
+        return is_promotion() ? static_cast<Piece>(KNIGHT + (flags() & 3)) : NO_PIECE;
+    }
+
+    constexpr bool operator==(const Move& other) const { return data == other.data; }
+    constexpr bool operator!=(const Move& other) const { return data != other.data; }
+};
+
+// Upper bound on legal moves in any position (the known maximum is 218)
+constexpr int MAX_MOVES = 256;
+
+// Fixed-capacity move buffer meant to live on the stack, so generating moves
+// never touches the heap. add() is unchecked: MAX_MOVES cannot be exceeded.
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int count = 0;
+
+    void add(const Move& move) { moves[count++] = move; }
+    void clear() { count = 0; }
+
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
 };
 
 enum Color {
@@ -0,0 +1,289 @@
+#include "uci.h"
+#include "board.h"
+#include "movegen.h"
+#include "nnue.h"
+#include "perft.h"
+#include "search.h"
+#include "util.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace UCI {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const std::string STARTPOS = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Legal move matching a UCI move string, or Move::none()
+Move parse_move(const Board& board, const std::string& str) {
+    MoveList moves;
+    MoveGen::generate_legal_moves(board, moves);
+    for (const Move& m : moves)
+        if (move_to_string(m) == str)
+            return m;
+    return Move::none();
+}
+
+// Split the remaining clock into a target time for this move and a hard
+// limit. Without "movestogo" the game is assumed to last another 30 moves,
+// and most of the increment is spent right away. The hard limit leaves a
+// margin for the move overhead and never touches the last fifth of the clock.
+void set_time_limits(Search::Limits& limits, int64_t time, int64_t inc, int moves_to_go, int64_t overhead) {
+    int mtg = moves_to_go > 0 ? std::min(moves_to_go, 40) : 30;
+    int64_t available = std::max<int64_t>(time - overhead, 1);
+    int64_t cap = std::max<int64_t>(available * 8 / 10, 1);
+
+    limits.optimum_ms = std::min(available / mtg + inc * 3 / 4, cap);
+    limits.movetime_ms = std::min(limits.optimum_ms * 4, cap);
+}
+
+class Engine {
+public:
+    Engine(std::ostream& out) : out(out), tt(16) { board.set_fen(STARTPOS); }
+    ~Engine() { wait(); }
+
+    void position(std::istringstream& is);
+    void go(std::istringstream& is);
+    void setoption(std::istringstream& is);
+    void perft(int depth);
+    void new_game();
+    void print();
+
+    void stop() {
+        stop_flag = true;
+        ponder_flag = false;
+        infinite = false;
+    }
+
+    // Pondering turns into a normal timed search. If the target time already
+    // went by while pondering, move right away.
+    void ponderhit() {
+        ponder_flag = false;
+        if (limits.optimum_ms && Clock::now() - search_start >= std::chrono::milliseconds(limits.optimum_ms))
+            stop_flag = true;
+    }
+
+    // Stop any running search and join its thread
+    void wait() {
+        if (searcher.joinable()) {
+            stop();
+            searcher.join();
+        }
+    }
+
+private:
+    std::ostream& out;
+
+    Board board;
+    std::vector<uint64_t> history;  // Keys of the positions before `board`
+
+    Search::TranspositionTable tt;
+    int threads = 1;
+    int64_t move_overhead = 10;
+
+    Search::Limits limits;
+    std::atomic<bool> stop_flag{false};
+    std::atomic<bool> ponder_flag{false};
+    std::atomic<bool> infinite{false};
+    Clock::time_point search_start;
+    std::thread searcher;
+};
+
+void Engine::position(std::istringstream& is) {
+    std::string token, fen;
+    is >> token;
+
+    if (token == "startpos") {
+        fen = STARTPOS;
+        is >> token;  // "moves"
+    } else if (token == "fen") {
+        while (is >> token && token != "moves")
+            fen += token + " ";
+    } else {
+        return;
+    }
+
+    // Nothing changes unless the FEN and every move are valid
+    Board b;
+    if (!b.set_fen(fen)) {
+        out << "info string invalid fen " << fen << std::endl;
+        return;
+    }
+
+    std::vector<uint64_t> keys;
+    while (is >> token) {
+        Move m = parse_move(b, token);
+        if (m == Move::none()) {
+            out << "info string illegal move " << token << std::endl;
+            return;
+        }
+        keys.push_back(b.key);
+        b.make_move(m);
+    }
+
+    board = b;
+    history = std::move(keys);
+}
+
+void Engine::go(std::istringstream& is) {
+    wait();
+
+    limits = Search::Limits{};
+    limits.stop = &stop_flag;
+    limits.ponder = &ponder_flag;
+
+    int64_t time[COLOR_NB] = {0, 0}, inc[COLOR_NB] = {0, 0};
+    int moves_to_go = 0;
+    bool timed = false, ponder = false, inf = false;
+
+    std::string token;
+    while (is >> token) {
+        if (token == "depth")           is >> limits.depth;
+        else if (token == "nodes")      is >> limits.nodes;
+        else if (token == "movetime")   is >> limits.movetime_ms;
+        else if (token == "wtime")      { is >> time[WHITE]; timed = true; }
+        else if (token == "btime")      { is >> time[BLACK]; timed = true; }
+        else if (token == "winc")       is >> inc[WHITE];
+        else if (token == "binc")       is >> inc[BLACK];
+        else if (token == "movestogo")  is >> moves_to_go;
+        else if (token == "ponder")     ponder = true;
+        else if (token == "infinite")   inf = true;
+        else if (token == "perft") {
+            int depth = 0;
+            is >> depth;
+            perft(depth);
+            return;
+        }
+    }
+
+    limits.depth = std::clamp(limits.depth, 1, Search::MAX_PLY - 1);
+    if (limits.movetime_ms)
+        limits.movetime_ms = std::max<int64_t>(limits.movetime_ms - move_overhead, 1);
+    else if (timed)
+        set_time_limits(limits, time[board.side_to_move], inc[board.side_to_move], moves_to_go, move_overhead);
+
+    stop_flag = false;
+    ponder_flag = ponder;
+    infinite = inf;
+    search_start = Clock::now();
+
+    // The search thread works on copies, so "position" may be sent while it
+    // runs. "bestmove" must not be sent before "stop" or "ponderhit" when
+    // pondering or searching infinitely, even if the search ends on its own.
+    searcher = std::thread([this, b = board, keys = history] {
+        Search::Result r = Search::search(b, limits, tt, threads, keys, out);
+
+        while ((ponder_flag || infinite) && !stop_flag)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        std::string line = "bestmove " + (r.best_move == Move::none() ? "0000" : move_to_string(r.best_move));
+        if (r.pv.size() >= 2)
+            line += " ponder " + move_to_string(r.pv[1]);
+        out << line + "\n" << std::flush;
+    });
+}
+
+void Engine::setoption(std::istringstream& is) {
+    std::string token, name, value;
+
+    is >> token;  // "name"
+    while (is >> token && token != "value")
+        name += (name.empty() ? "" : " ") + token;
+    while (is >> token)
+        value += (value.empty() ? "" : " ") + token;
+
+    if (name == "Hash") {
+        wait();
+        tt.resize(std::clamp(std::atoi(value.c_str()), 1, 65536));
+    } else if (name == "Threads") {
+        threads = std::clamp(std::atoi(value.c_str()), 1, 512);
+    } else if (name == "Move Overhead") {
+        move_overhead = std::clamp(std::atoi(value.c_str()), 0, 5000);
+    } else if (name == "Clear Hash") {
+        new_game();
+    } else if (name == "EvalFile") {
+        // Searches attach accumulators only while a network is loaded. The
+        // table's static evals and scores come from the old evaluation, so a
+        // change of network drops them.
+        wait();
+        if (value.empty() || value == "<empty>") {
+            NNUE::unload();
+            tt.clear();
+        } else if (!NNUE::load(value)) {
+            out << "info string cannot load network " << value << std::endl;
+        } else {
+            tt.clear();
+            out << "info string network " << value << " loaded" << std::endl;
+        }
+    } else if (name == "Ponder") {
+        // Nothing to set up: pondering is requested per search with "go ponder"
+    } else {
+        out << "info string unknown option " << name << std::endl;
+    }
+}
+
+void Engine::perft(int depth) {
+    wait();
+    Board b = board;
+    Perft::divide(b, std::max(depth, 1), out);
+}
+
+void Engine::new_game() {
+    wait();
+    tt.clear();
+}
+
+void Engine::print() {
+    board.print();
+    out << "Fen: " << board.fen() << "\nKey: " << std::hex << board.key << std::dec << std::endl;
+}
+
+} // namespace
+
+void loop(std::istream& in, std::ostream& out) {
+    Engine engine(out);
+    std::string line, token;
+
+    while (std::getline(in, line)) {
+        std::istringstream is(line);
+        token.clear();
+        is >> std::skipws >> token;
+
+        if (token == "uci") {
+            out << "id name chess-engine\n"
+                << "id author the chess-engine authors\n"
+                << "option name Hash type spin default 16 min 1 max 65536\n"
+                << "option name Threads type spin default 1 min 1 max 512\n"
+                << "option name Move Overhead type spin default 10 min 0 max 5000\n"
+                << "option name Clear Hash type button\n"
+                << "option name Ponder type check default false\n"
+                << "option name EvalFile type string default <empty>\n"
+                << "uciok" << std::endl;
+        }
+        else if (token == "isready")     out << "readyok" << std::endl;
+        else if (token == "ucinewgame")  engine.new_game();
+        else if (token == "position")    engine.position(is);
+        else if (token == "go")          engine.go(is);
+        else if (token == "stop")        engine.stop();
+        else if (token == "ponderhit")   engine.ponderhit();
+        else if (token == "setoption")   engine.setoption(is);
+        else if (token == "perft")       { int depth = 0; is >> depth; engine.perft(depth); }
+        else if (token == "d")           engine.print();
+        else if (token == "quit")        break;
+        else if (!token.empty())         out << "info string unknown command " << token << std::endl;
+    }
+
+    engine.wait();
+}
+
+}
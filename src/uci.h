@@ -0,0 +1,14 @@
+#pragma once
+
+#include <iostream>
+
+namespace UCI {
+    // Read UCI commands from `in` until "quit" or end of input, answering on
+    // `out`. "go" starts the search on a separate thread, so "stop",
+    // "ponderhit" and "isready" are answered while it runs.
+    //
+    // Besides the standard commands:
+    //   perft <depth>   per-move perft counts of the current position
+    //   d               print the current position and its FEN
+    void loop(std::istream& in = std::cin, std::ostream& out = std::cout);
+}
@@ -10,6 +10,19 @@ inline std::string square_to_string(int square) {
     return std::string{file, rank};
 }
 
+// Coordinate notation, e.g. "e2e4" or "e7e8q"
+inline std::string move_to_string(const Move& move) {
+    std::string s = square_to_string(move.from()) + square_to_string(move.to());
+    switch (move.promotion()) {
+        case KNIGHT: s += 'n'; break;
+        case BISHOP: s += 'b'; break;
+        case ROOK: s += 'r'; break;
+        case QUEEN: s += 'q'; break;
+        default: break;
+    }
+    return s;
+}
+
 inline std::string piece_to_string(Piece piece) {
     switch (piece) {
         case PAWN: return "Pawn";
@@ -21,3 +34,21 @@ inline std::string piece_to_string(Piece piece) {
         default: return "No piece";
     }
 }
+
+// xorshift64* pseudo-random generator, used wherever tables need reproducible
+// random numbers (magics, Zobrist keys)
+struct PRNG {
+    uint64_t s;
+
+    constexpr uint64_t rand() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+
+    // Numbers with few bits set, which make good magic candidates
+    constexpr uint64_t sparse_rand() {
+        return rand() & rand() & rand();
+    }
+};
@@ -0,0 +1,74 @@
+#include "worksteal.h"
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WorkStealing {
+
+namespace {
+
+struct alignas(64) WorkerQueue {
+    std::mutex mutex;
+    std::deque<size_t> tasks;
+
+    bool pop_back(size_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty())
+            return false;
+        task = tasks.back();
+        tasks.pop_back();
+        return true;
+    }
+
+    bool steal_front(size_t& task) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty())
+            return false;
+        task = tasks.front();
+        tasks.pop_front();
+        return true;
+    }
+};
+
+} // namespace
+
+void run(size_t count, int threads, const std::function<void(size_t, int)>& fn) {
+    if (threads < 1)
+        threads = 1;
+
+    std::vector<WorkerQueue> queues(threads);
+    for (size_t task = 0; task < count; task++)
+        queues[task % threads].tasks.push_back(task);
+
+    auto worker = [&](int id) {
+        size_t task;
+        while (true) {
+            if (queues[id].pop_back(task)) {
+                fn(task, id);
+                continue;
+            }
+
+            // Own deque is empty: look for work elsewhere. No new tasks are
+            // ever added, so a full pass without success means we are done.
+            bool stolen = false;
+            for (int i = 1; i < threads && !stolen; i++)
+                stolen = queues[(id + i) % threads].steal_front(task);
+
+            if (!stolen)
+                return;
+            fn(task, id);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (int id = 1; id < threads; id++)
+        pool.emplace_back(worker, id);
+    worker(0);
+
+    for (std::thread& t : pool)
+        t.join();
+}
+
+}
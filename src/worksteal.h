@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace WorkStealing {
+    // Run fn(task, worker) for every task in [0, count) on `threads` threads and
+    // return once all tasks are done. Tasks are dealt round-robin to per-worker
+    // deques; a worker pops from the back of its own deque and, once it runs
+    // dry, steals from the front of the others, so uneven subtrees still keep
+    // every core busy. Only the deque operations take a lock.
+    void run(size_t count, int threads, const std::function<void(size_t task, int worker)>& fn);
+}
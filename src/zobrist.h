@@ -0,0 +1,47 @@
+#pragma once
+
+#include "types.h"
+#include "util.h"
+
+// Random keys for incremental position hashing, generated at compile time
+namespace Zobrist {
+    namespace detail {
+        struct Keys {
+            uint64_t psq[COLOR_NB][PIECE_NB][64];
+            uint64_t castling[16];   // Indexed by the castling rights bit set
+            uint64_t en_passant[8];  // Indexed by the en passant file
+            uint64_t side;           // Toggled when black is to move
+        };
+
+        constexpr Keys make_keys() {
+            Keys keys{};
+            PRNG rng{1070372ULL};
+
+            for (int c = WHITE; c <= BLACK; c++)
+                for (int p = PAWN; p < PIECE_NB; p++)
+                    for (int sq = 0; sq < 64; sq++)
+                        keys.psq[c][p][sq] = rng.rand();
+
+            // Combined rights hash as the XOR of their single-right keys, so that
+            // toggling one right is the same as swapping the whole entry
+            uint64_t single[4] = {rng.rand(), rng.rand(), rng.rand(), rng.rand()};
+            for (int rights = 0; rights < 16; rights++)
+                for (int i = 0; i < 4; i++)
+                    if (rights & (1 << i))
+                        keys.castling[rights] ^= single[i];
+
+            for (int file = 0; file < 8; file++)
+                keys.en_passant[file] = rng.rand();
+
+            keys.side = rng.rand();
+            return keys;
+        }
+
+        inline constexpr Keys keys = make_keys();
+    }
+
+    inline constexpr const auto& psq = detail::keys.psq;
+    inline constexpr const auto& castling = detail::keys.castling;
+    inline constexpr const auto& en_passant = detail::keys.en_passant;
+    inline constexpr uint64_t side = detail::keys.side;
+}